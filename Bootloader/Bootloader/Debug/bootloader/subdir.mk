@@ -5,23 +5,53 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../bootloader/bl_clock.c \
+../bootloader/bl_crc.c \
+../bootloader/bl_flash.c \
+../bootloader/bl_handoff.c \
+../bootloader/bl_image.c \
+../bootloader/bl_services.c \
+../bootloader/bl_slot.c \
+../bootloader/bl_stage0.c \
+../bootloader/bl_swap.c \
+../bootloader/bl_uart.c \
 ../bootloader/bootloader.c 
 
 OBJS += \
+./bootloader/bl_clock.o \
+./bootloader/bl_crc.o \
+./bootloader/bl_flash.o \
+./bootloader/bl_handoff.o \
+./bootloader/bl_image.o \
+./bootloader/bl_services.o \
+./bootloader/bl_slot.o \
+./bootloader/bl_stage0.o \
+./bootloader/bl_swap.o \
+./bootloader/bl_uart.o \
 ./bootloader/bootloader.o 
 
 C_DEPS += \
+./bootloader/bl_clock.d \
+./bootloader/bl_crc.d \
+./bootloader/bl_flash.d \
+./bootloader/bl_handoff.d \
+./bootloader/bl_image.d \
+./bootloader/bl_services.d \
+./bootloader/bl_slot.d \
+./bootloader/bl_stage0.d \
+./bootloader/bl_swap.d \
+./bootloader/bl_uart.d \
 ./bootloader/bootloader.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 bootloader/%.o bootloader/%.su bootloader/%.cyclo: ../bootloader/%.c bootloader/subdir.mk
-	arm-none-eabi-gcc "$<" -mcpu=cortex-m3 -std=gnu11 -g3 -DDEBUG -DUSE_HAL_DRIVER -DSTM32F103xB -c -I../Core/Inc -I"/media/abdelrahman/New Volume/stm/Bootloader/bootloader" -I../Drivers/STM32F1xx_HAL_Driver/Inc/Legacy -I../Drivers/STM32F1xx_HAL_Driver/Inc -I../Drivers/CMSIS/Device/ST/STM32F1xx/Include -I../Drivers/CMSIS/Include -O0 -ffunction-sections -fdata-sections -Wall -fstack-usage -fcyclomatic-complexity -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" --specs=nano.specs -mfloat-abi=soft -mthumb -o "$@"
+	arm-none-eabi-gcc "$<" -mcpu=cortex-m3 -std=gnu11 -g3 -DDEBUG -DUSE_HAL_DRIVER -DSTM32F103xB -c -I../Core/Inc -I"/media/abdelrahman/New Volume/stm/Bootloader/bootloader" -I../Drivers/STM32F1xx_HAL_Driver/Inc/Legacy -I../Drivers/STM32F1xx_HAL_Driver/Inc -I../Drivers/CMSIS/Device/ST/STM32F1xx/Include -I../Drivers/CMSIS/Include -Og -ffunction-sections -fdata-sections -Wall -fstack-usage -fcyclomatic-complexity -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" --specs=nano.specs -mfloat-abi=soft -mthumb -o "$@"
 
 clean: clean-bootloader
 
 clean-bootloader:
-	-$(RM) ./bootloader/bootloader.cyclo ./bootloader/bootloader.d ./bootloader/bootloader.o ./bootloader/bootloader.su
+	-$(RM) ./bootloader/bl_clock.cyclo ./bootloader/bl_clock.d ./bootloader/bl_clock.o ./bootloader/bl_clock.su ./bootloader/bl_crc.cyclo ./bootloader/bl_crc.d ./bootloader/bl_crc.o ./bootloader/bl_crc.su ./bootloader/bl_flash.cyclo ./bootloader/bl_flash.d ./bootloader/bl_flash.o ./bootloader/bl_flash.su ./bootloader/bl_handoff.cyclo ./bootloader/bl_handoff.d ./bootloader/bl_handoff.o ./bootloader/bl_handoff.su ./bootloader/bl_image.cyclo ./bootloader/bl_image.d ./bootloader/bl_image.o ./bootloader/bl_image.su ./bootloader/bl_services.cyclo ./bootloader/bl_services.d ./bootloader/bl_services.o ./bootloader/bl_services.su ./bootloader/bl_slot.cyclo ./bootloader/bl_slot.d ./bootloader/bl_slot.o ./bootloader/bl_slot.su ./bootloader/bl_stage0.cyclo ./bootloader/bl_stage0.d ./bootloader/bl_stage0.o ./bootloader/bl_stage0.su ./bootloader/bl_swap.cyclo ./bootloader/bl_swap.d ./bootloader/bl_swap.o ./bootloader/bl_swap.su ./bootloader/bl_uart.cyclo ./bootloader/bl_uart.d ./bootloader/bl_uart.o ./bootloader/bl_uart.su ./bootloader/bootloader.cyclo ./bootloader/bootloader.d ./bootloader/bootloader.o ./bootloader/bootloader.su
 
 .PHONY: clean-bootloader
 
@@ -0,0 +1,58 @@
+/*
+ * bl_boot_info.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  Boot info block the bootloader leaves for the application it starts. The header
+ *  only needs stdint.h, so applications can include it as it is.
+ */
+
+#ifndef BL_BOOT_INFO_H_
+#define BL_BOOT_INFO_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include <stdint.h>
+
+
+//-----------------------------
+// Boot Info Block
+//-----------------------------
+// @brief Address of the block, the last 64 bytes of the SRAM: the application linker script keeps them out of its RAM.
+#define BL_BOOT_INFO_ADDRESS   0x20004FC0
+// @brief First word of a block written by the bootloader ("INFO").
+#define BL_BOOT_INFO_MAGIC     0x4F464E49
+// @brief Layout version, raised when fields are added at the end.
+#define BL_BOOT_INFO_VERSION            1
+
+// @brief Boot reasons.
+#define BL_BOOT_REASON_AUTOBOOT         0   // active slot started at reset
+#define BL_BOOT_REASON_FALLBACK         1   // active slot not bootable, the other slot started
+#define BL_BOOT_REASON_COMMAND          2   // BL_JUMP_TO_MAIN sent by the host
+#define BL_BOOT_REASON_RAM              3   // BL_RAM_EXEC_CMD sent by the host
+
+// @brief Value of slot when the image was not started from a slot.
+#define BL_BOOT_INFO_NO_SLOT         0xFF
+
+// @brief Handoff flags, the peripheral state left to the application.
+#define BL_BOOT_INFO_CLOCK_KEPT      0x01   // system clock as configured by the bootloader, SysTick stopped
+#define BL_BOOT_INFO_UART_KEPT       0x02   // USART1 enabled at uart_baud_rate, its DMA and interrupts off
+
+// block at BL_BOOT_INFO_ADDRESS, written right before the jump
+typedef struct {
+	uint32_t magic;             // BL_BOOT_INFO_MAGIC, anything else: not started by the bootloader
+	uint8_t version;            // BL_BOOT_INFO_VERSION
+	uint8_t boot_reason;        // BL_BOOT_REASON_...
+	uint8_t slot;               // slot started, BL_BOOT_INFO_NO_SLOT otherwise
+	uint8_t flags;              // BL_BOOT_INFO_..._KEPT
+	uint32_t reset_cause;       // reset flags of RCC->CSR (bits 26 to 31), cleared by the bootloader
+	uint32_t image_CRC;         // CRC of the image checked before the jump, 0 if none was
+	uint32_t handoff_cycles;    // CPU cycles from reset to the jump
+	uint32_t system_clock;      // SystemCoreClock at the jump in Hz
+	uint32_t uart_baud_rate;    // USART1 rate with BL_BOOT_INFO_UART_KEPT, 0 otherwise
+}BL_Boot_Info;
+
+
+#endif /* BL_BOOT_INFO_H_ */
@@ -0,0 +1,128 @@
+/*
+ * bl_clock.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_clock.h"
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Clock_Config_PLL
+* @brief - Runs SYSCLK from the PLL fed by the given source.
+* @param [in] - uint32_t pll_source: RCC_PLLSOURCE_HSI_DIV2 or RCC_PLLSOURCE_HSE
+* @param [in] - uint32_t pll_mul: PLL multiplication factor (RCC_PLL_MULx)
+* @retval - BL_Status (BL_OK if SYSCLK runs from the PLL, BL_Error if the oscillator or PLL did not start)
+* Note- HAL_RCC_ClockConfig raises the flash latency before switching to the faster clock.
+*/
+static BL_Status BL_Clock_Config_PLL(uint32_t pll_source, uint32_t pll_mul)
+{
+	RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+	RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+	if(pll_source == RCC_PLLSOURCE_HSE)
+	{
+		RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+		RCC_OscInitStruct.HSEState = RCC_HSE_ON;
+		RCC_OscInitStruct.HSEPredivValue = RCC_HSE_PREDIV_DIV1;
+	}else
+	{
+		RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+		RCC_OscInitStruct.HSIState = RCC_HSI_ON;
+		RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+	}
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+	RCC_OscInitStruct.PLL.PLLSource = pll_source;
+	RCC_OscInitStruct.PLL.PLLMUL = pll_mul;
+
+	if(HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+	{
+		return BL_Error;
+	}
+
+	// APB1 is limited to 36 MHz, APB2 (USART1) runs at SYSCLK
+	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
+								|RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;
+	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+
+	if(HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_2) != HAL_OK)
+	{
+		return BL_Error;
+	}
+
+	return BL_OK;
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Clock_Init
+* @brief - Switches the system clock to the configuration selected by BL_CLOCK_CONFIG.
+* @retval - BL_Status (BL_OK if the selected clock is running, BL_Error if it fell back to a slower one)
+* Note- Must be called before the peripherals are initialised since their baud rates are computed
+*       from the bus clocks. A missing crystal falls back to HSI/2 x 16, a PLL that does not lock
+*       leaves the bootloader on the 8 MHz HSI set by SystemClock_Config.
+*/
+BL_Status BL_Clock_Init(void)
+{
+	BL_Status bl_status = BL_OK;
+
+#if (BL_CLOCK_CONFIG == BL_CLOCK_HSE_72MHZ)
+	if(BL_Clock_Config_PLL(RCC_PLLSOURCE_HSE, RCC_PLL_MUL9) != BL_OK)
+	{
+		bl_status = BL_Error;
+		BL_Clock_Config_PLL(RCC_PLLSOURCE_HSI_DIV2, RCC_PLL_MUL16);
+	}
+#elif (BL_CLOCK_CONFIG == BL_CLOCK_HSI_64MHZ)
+	bl_status = BL_Clock_Config_PLL(RCC_PLLSOURCE_HSI_DIV2, RCC_PLL_MUL16);
+#endif
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Clock_DeInit
+* @brief - Returns the clock tree to its reset state before the application is started.
+* @retval - None
+* Note- HAL_RCC_DeInit leaves the flash wait states and SysTick untouched, both are reset here so
+*       the application starts with the same configuration it would get out of reset.
+*/
+void BL_Clock_DeInit(void)
+{
+	HAL_RCC_DeInit();
+
+	// HSI is running now, so the wait states can go back to zero with the reset prefetch setting
+	FLASH->ACR = FLASH_ACR_PRFTBE;
+
+	BL_Clock_Stop_SysTick();
+}
+
+/**================================================================
+* @Fn- BL_Clock_Stop_SysTick
+* @brief - Returns SysTick to its reset state and clears its pending interrupt.
+* @retval - None
+* Note- Used alone when the application keeps the bootloader clock, the HAL tick must not fire
+*       into the application before it sets up its own.
+*/
+void BL_Clock_Stop_SysTick(void)
+{
+	SysTick->CTRL = 0;
+	SysTick->LOAD = 0;
+	SysTick->VAL = 0;
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+}
@@ -0,0 +1,27 @@
+/*
+ * bl_clock.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_CLOCK_H_
+#define BL_CLOCK_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+/*
+* ===============================================
+* APIs Supported by "BL Clock"
+* ===============================================
+*/
+BL_Status BL_Clock_Init(void);
+void BL_Clock_DeInit(void);
+void BL_Clock_Stop_SysTick(void);
+
+
+#endif /* BL_CLOCK_H_ */
@@ -0,0 +1,141 @@
+/*
+ * bl_crc.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_crc.h"
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_CRC_Feed_Words
+* @brief - Feeds whole words into the CRC unit.
+* @param [in] - const uint8_t *data: First word (4-byte aligned for the DMA path)
+* @param [in] - uint32_t number_of_words: Number of words to feed
+* @retval - None
+* Note- Long aligned blocks are moved into CRC->DR by the memory-to-memory DMA channel, the source
+*       address increments and the destination stays on the data register. Short or unaligned
+*       blocks are written by the CPU since the DMA setup would cost more than it saves.
+*       The channel is driven through its registers and polled, no handle or variable in SRAM is
+*       used, so the application can call it through the service table (see bl_services.c).
+*/
+static void BL_CRC_Feed_Words(const uint8_t *data, uint32_t number_of_words)
+{
+	if(number_of_words >= BL_CRC_DMA_MIN_WORDS && ((uint32_t)data & 0x3) == 0)
+	{
+		while(number_of_words > 0)
+		{
+			uint32_t block = (number_of_words > 0xFFFF) ? 0xFFFF : number_of_words;
+
+			// memory to memory: CPAR is the incremented source, CMAR the data register
+			DMA1_Channel1->CCR = 0;
+			DMA1->IFCR = DMA_IFCR_CGIF1;
+			DMA1_Channel1->CPAR = (uint32_t)data;
+			DMA1_Channel1->CMAR = (uint32_t)&CRC->DR;
+			DMA1_Channel1->CNDTR = block;
+			DMA1_Channel1->CCR = DMA_CCR_MEM2MEM | DMA_CCR_PL_0 | DMA_CCR_MSIZE_1 | DMA_CCR_PSIZE_1 |
+			                     DMA_CCR_PINC | DMA_CCR_EN;
+
+			while(!(DMA1->ISR & (DMA_ISR_TCIF1 | DMA_ISR_TEIF1)));
+
+			DMA1_Channel1->CCR = 0;
+			DMA1->IFCR = DMA_IFCR_CGIF1;
+
+			data += block * 4;
+			number_of_words -= block;
+		}
+	}else
+	{
+		const uint32_t *word = (const uint32_t *)data;
+
+		while(number_of_words-- > 0)
+		{
+			CRC->DR = *word++;
+		}
+	}
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_CRC_Reset
+* @brief - Starts a new CRC computation (CRC register back to 0xFFFFFFFF).
+* @retval - None
+*/
+void BL_CRC_Reset(void)
+{
+	CRC->CR = CRC_CR_RESET;
+}
+
+/**================================================================
+* @Fn- BL_CRC_Calculate
+* @brief - Computes the STM32 CRC-32 of a buffer.
+* @param [in] - const uint8_t *data: Buffer to compute the CRC of
+* @param [in] - uint32_t length: Number of bytes in the buffer
+* @retval - uint32_t (CRC-32, polynomial 0x04C11DB7, initial value 0xFFFFFFFF)
+* Note- The buffer is processed as little-endian 32-bit words. When the length is not a multiple
+*       of 4 the last 1 to 3 bytes are zero-padded into one final word.
+*/
+uint32_t BL_CRC_Calculate(const uint8_t *data, uint32_t length)
+{
+	BL_CRC_Reset();
+
+	return BL_CRC_Accumulate(data, length);
+}
+
+/**================================================================
+* @Fn- BL_CRC_Accumulate
+* @brief - Continues the current CRC computation with the next part of a buffer.
+* @param [in] - const uint8_t *data: Next part of the buffer
+* @param [in] - uint32_t length: Number of bytes in this part
+* @retval - uint32_t (CRC-32 of everything fed since BL_CRC_Reset)
+* Note- Only the last part may have a length that is not a multiple of 4, its tail is zero-padded
+*       like in BL_CRC_Calculate, so feeding a buffer in parts gives the same CRC as in one call.
+*/
+uint32_t BL_CRC_Accumulate(const uint8_t *data, uint32_t length)
+{
+	uint32_t tail_length = length & 0x3;
+	uint32_t tail_word = 0;
+
+	BL_CRC_Feed_Words(data, length / 4);
+
+	if(tail_length > 0)
+	{
+		memcpy(&tail_word, data + (length - tail_length), tail_length);
+		CRC->DR = tail_word;
+	}
+
+	return CRC->DR;
+}
+
+/**================================================================
+* @Fn- BL_CRC_DeInit
+* @brief - Returns the CRC unit and its memory-to-memory DMA channel to their reset state.
+* @param [in] - None
+* @retval - None
+* Note- Called before the application is started, the DMA channel would otherwise stay configured
+*       on the CRC data register. The DMA1 clock stays on for the UART channels, it is stopped by
+*       Bootloader_Jump_To_Application.
+*/
+void BL_CRC_DeInit(void)
+{
+	LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_1);
+	LL_DMA_ConfigTransfer(DMA1, LL_DMA_CHANNEL_1, 0);
+	LL_DMA_ClearFlag_GI1(DMA1);
+
+	LL_CRC_ResetCRCCalculationUnit(CRC);
+	LL_CRC_Write_IDR(CRC, 0);
+	LL_AHB1_GRP1_DisableClock(LL_AHB1_GRP1_PERIPH_CRC);
+}
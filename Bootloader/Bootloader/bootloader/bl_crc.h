@@ -0,0 +1,28 @@
+/*
+ * bl_crc.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_CRC_H_
+#define BL_CRC_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+/*
+* ===============================================
+* APIs Supported by "BL CRC"
+* ===============================================
+*/
+void BL_CRC_Reset(void);
+uint32_t BL_CRC_Calculate(const uint8_t *data, uint32_t length);
+uint32_t BL_CRC_Accumulate(const uint8_t *data, uint32_t length);
+void BL_CRC_DeInit(void);
+
+
+#endif /* BL_CRC_H_ */
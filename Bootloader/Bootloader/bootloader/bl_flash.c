@@ -0,0 +1,342 @@
+/*
+ * bl_flash.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_flash.h"
+
+
+//===============================================
+//Global Variables
+//===============================================
+// pages erased in the background by the FLASH interrupt ahead of the writes
+static struct {
+	volatile uint8_t active;
+	volatile uint8_t paused;
+	volatile uint8_t busy;          // a page erase started by the interrupt is running
+	volatile uint8_t next_page;
+	uint8_t end_page;
+}erase_ahead;
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Ahead_Next
+* @brief - Starts erasing the next page of the erase-ahead range that is not erased yet.
+* @param [in] - None
+* @retval - None
+* Note- Runs from RAM, it is called from the FLASH interrupt. The end of the erase raises the
+*       interrupt again, which goes on with the page after it until the range is done or paused.
+*/
+static __RAM_FUNC void BL_Flash_Erase_Ahead_Next(void)
+{
+	while(!erase_ahead.paused && erase_ahead.next_page < erase_ahead.end_page)
+	{
+		const volatile uint32_t *word = (const volatile uint32_t *)(FLASH_BASE + erase_ahead.next_page * PAGE_SIZE);
+		uint16_t i = 0;
+
+		while(i < PAGE_SIZE / 4 && word[i] == 0xFFFFFFFF)
+		{
+			i++;
+		}
+
+		if(i < PAGE_SIZE / 4)
+		{
+			erase_ahead.busy = 1;
+			FLASH->CR |= FLASH_CR_PER;
+			FLASH->AR = (uint32_t)word;
+			FLASH->CR |= FLASH_CR_STRT | FLASH_CR_EOPIE | FLASH_CR_ERRIE;
+			erase_ahead.next_page++;
+			break;
+		}
+
+		erase_ahead.next_page++;
+	}
+}
+
+/**================================================================
+* @Fn- BL_Flash_Program_Halfwords
+* @brief - Programs the halfwords of a buffer that differ from the flash.
+* @param [in] - uint32_t address: Halfword aligned flash address, the flash must be unlocked
+* @param [in] - const uint8_t *data: Data to program
+* @param [in] - uint32_t length: Number of bytes, an odd last byte is padded with 0xFF
+* @retval - BL_Status (BL_OK if every halfword reads back as written, BL_Error otherwise)
+* Note- Inlined into BL_Flash_Program (RAM) and BL_Flash_Program_In_Place (flash). PG stays set for
+*       the whole buffer and the error flags are only checked once at the end, unlike
+*       HAL_FLASH_Program which goes through the HAL state, the error flags and a HAL_GetTick timeout
+*       for every halfword. Each halfword to change has to be erased, a PGERR is reported otherwise.
+*       No function may be called from here.
+*/
+static inline __attribute__((always_inline)) BL_Status BL_Flash_Program_Halfwords(uint32_t address, const uint8_t *data, uint32_t length)
+{
+	volatile uint16_t *destination = (volatile uint16_t *)address;
+	uint8_t mismatch = 0;
+
+	while(FLASH->SR & FLASH_SR_BSY);
+
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+	FLASH->CR |= FLASH_CR_PG;
+
+	for(uint32_t offset = 0; offset < length; offset += 2)
+	{
+		uint16_t halfword = data[offset] | ((offset + 1 < length) ? data[offset + 1] : 0xFF) << 8;
+
+		if(*destination != halfword)
+		{
+			*destination = halfword;
+			while(FLASH->SR & FLASH_SR_BSY);
+
+			mismatch |= (*destination != halfword);
+		}
+
+		destination++;
+	}
+
+	FLASH->CR &= ~FLASH_CR_PG;
+
+	uint32_t errors = FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR);
+	FLASH->SR = errors | FLASH_SR_EOP;
+
+	return (errors || mismatch) ? BL_Error : BL_OK;
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Flash_Unlock
+* @brief - Unlocks the flash control register for programming and erasing.
+* @param [in] - None
+* @retval - BL_Status (BL_OK if FLASH->CR is unlocked, BL_Error otherwise)
+* Note- A wrong key sequence locks FLASH->CR until the next reset.
+*/
+BL_Status BL_Flash_Unlock(void)
+{
+	if(FLASH->CR & FLASH_CR_LOCK)
+	{
+		FLASH->KEYR = FLASH_KEY1;
+		FLASH->KEYR = FLASH_KEY2;
+	}
+
+	return (FLASH->CR & FLASH_CR_LOCK) ? BL_Error : BL_OK;
+}
+
+/**================================================================
+* @Fn- BL_Flash_Lock
+* @brief - Locks the flash control register again.
+* @param [in] - None
+* @retval - None
+*/
+void BL_Flash_Lock(void)
+{
+	FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/**================================================================
+* @Fn- BL_Flash_Program
+* @brief - Programs the halfwords of a buffer that differ from the flash.
+* @param [in] - uint32_t address: Halfword aligned flash address, the flash must be unlocked
+* @param [in] - const uint8_t *data: Data to program
+* @param [in] - uint32_t length: Number of bytes, an odd last byte is padded with 0xFF
+* @retval - BL_Status (BL_OK if every halfword reads back as written, BL_Error otherwise)
+* Note- Runs from RAM, so the CPU keeps fetching instructions while the flash is busy and writes the
+*       next halfword as soon as BSY clears. See BL_Flash_Program_Halfwords.
+*/
+__RAM_FUNC BL_Status BL_Flash_Program(uint32_t address, const uint8_t *data, uint32_t length)
+{
+	return BL_Flash_Program_Halfwords(address, data, length);
+}
+
+/**================================================================
+* @Fn- BL_Flash_Program_In_Place
+* @brief - Programs the halfwords of a buffer that differ from the flash, running from the flash.
+* @param [in] - uint32_t address: Halfword aligned flash address, the flash must be unlocked
+* @param [in] - const uint8_t *data: Data to program
+* @param [in] - uint32_t length: Number of bytes, an odd last byte is padded with 0xFF
+* @retval - BL_Status (BL_OK if every halfword reads back as written, BL_Error otherwise)
+* Note- Same as BL_Flash_Program, but the CPU stalls on its next fetch during each halfword write.
+*       For the few halfwords of a marker, and for the service table: once the application runs,
+*       the RAM copy of BL_Flash_Program is overwritten by its variables.
+*/
+BL_Status BL_Flash_Program_In_Place(uint32_t address, const uint8_t *data, uint32_t length)
+{
+	return BL_Flash_Program_Halfwords(address, data, length);
+}
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Page
+* @brief - Erases one flash page.
+* @param [in] - uint32_t address: Address in the page, the flash must be unlocked
+* @retval - BL_Status (BL_OK if the erase ended without error flag, BL_Error otherwise)
+* Note- The CPU stalls on its next fetch from the flash until the erase is done. The erase-ahead
+*       must not be busy.
+*/
+BL_Status BL_Flash_Erase_Page(uint32_t address)
+{
+	while(FLASH->SR & FLASH_SR_BSY);
+
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+	FLASH->CR |= FLASH_CR_PER;
+	FLASH->AR = address;
+	FLASH->CR |= FLASH_CR_STRT;
+
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->CR &= ~FLASH_CR_PER;
+
+	uint32_t errors = FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR);
+	FLASH->SR = errors | FLASH_SR_EOP;
+
+	return errors ? BL_Error : BL_OK;
+}
+
+/**================================================================
+* @Fn- BL_Flash_Mass_Erase
+* @brief - Erases the whole flash and programs the bootloader back from its SRAM copy.
+* @param [in] - const BL_Flash_Segment *bootloader_copy: Consecutive parts of the bootloader image,
+*                                                         all of even length but the last one
+* @param [in] - uint8_t number_of_segments: Number of parts
+* @retval - None
+* Note- Runs from RAM and has to be called with the interrupts disabled and the flash unlocked,
+*       nothing in flash can be used until it returns. It only returns once the bootloader reads
+*       back as the copy: returning into a broken bootloader would leave the chip without one,
+*       so a failed programming is retried with another mass erase.
+*/
+__RAM_FUNC void BL_Flash_Mass_Erase(const BL_Flash_Segment *bootloader_copy, uint8_t number_of_segments)
+{
+	BL_Status bl_status = BL_Error;
+
+	while(bl_status != BL_OK)
+	{
+		uint32_t address = FLASH_BASE;
+
+		while(FLASH->SR & FLASH_SR_BSY);
+
+		FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+		FLASH->CR |= FLASH_CR_MER;
+		FLASH->CR |= FLASH_CR_STRT;
+
+		while(FLASH->SR & FLASH_SR_BSY);
+		FLASH->CR &= ~FLASH_CR_MER;
+
+		bl_status = BL_OK;
+		for(uint8_t i = 0; i < number_of_segments; i++)
+		{
+			if(BL_Flash_Program(address, bootloader_copy[i].data, bootloader_copy[i].length) != BL_OK)
+			{
+				bl_status = BL_Error;
+			}
+			address += bootloader_copy[i].length;
+		}
+	}
+}
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Ahead_Start
+* @brief - Starts erasing a page range in the background.
+* @param [in] - uint8_t start_page: First page of the range
+* @param [in] - uint8_t number_of_pages: Number of pages in the range
+* @retval - None
+* Note- The pages are erased one after the other from the FLASH interrupt while the CPU waits for
+*       the UART, so the erase time is spent while the image is still on the wire. Pages that are
+*       already erased are skipped. The flash stays unlocked until BL_Flash_Erase_Ahead_Stop.
+*/
+void BL_Flash_Erase_Ahead_Start(uint8_t start_page, uint8_t number_of_pages)
+{
+	BL_Flash_Erase_Ahead_Stop();
+
+	erase_ahead.next_page = start_page;
+	erase_ahead.end_page = start_page + number_of_pages;
+	erase_ahead.active = 1;
+
+	HAL_NVIC_SetPriority(FLASH_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(FLASH_IRQn);
+
+	BL_Flash_Erase_Ahead_Resume();
+}
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Ahead_Pause
+* @brief - Waits for the background erase to finish its current page and holds it.
+* @param [in] - uint8_t page_number: Page about to be programmed or erased by the caller
+* @retval - None
+* Note- The erase-ahead never comes back to this page or the ones of the range before it, they are
+*       erased inline when needed. Does nothing without an erase-ahead range.
+*/
+void BL_Flash_Erase_Ahead_Pause(uint8_t page_number)
+{
+	if(erase_ahead.active)
+	{
+		erase_ahead.paused = 1;
+		if(erase_ahead.next_page <= page_number && page_number < erase_ahead.end_page)
+		{
+			erase_ahead.next_page = page_number + 1;
+		}
+
+		while(erase_ahead.busy);
+	}
+}
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Ahead_Resume
+* @brief - Lets the background erase go on after BL_Flash_Erase_Ahead_Pause.
+* @param [in] - None
+* @retval - None
+*/
+void BL_Flash_Erase_Ahead_Resume(void)
+{
+	if(erase_ahead.active)
+	{
+		// the paused caller may have locked the flash
+		BL_Flash_Unlock();
+		erase_ahead.paused = 0;
+		BL_Flash_Erase_Ahead_Next();
+	}
+}
+
+/**================================================================
+* @Fn- BL_Flash_Erase_Ahead_Stop
+* @brief - Ends the background erase and locks the flash.
+* @param [in] - None
+* @retval - None
+* Note- Waits for the page being erased, the pages not reached are left as they are.
+*/
+void BL_Flash_Erase_Ahead_Stop(void)
+{
+	if(erase_ahead.active)
+	{
+		BL_Flash_Erase_Ahead_Pause(0);
+		erase_ahead.active = 0;
+
+		HAL_NVIC_DisableIRQ(FLASH_IRQn);
+		BL_Flash_Lock();
+	}
+}
+
+/**================================================================
+* @Fn- FLASH_IRQHandler
+* @brief - Handles the end of a page erase started by the erase-ahead.
+* @param [in] - None
+* @retval - None
+* Note- Replaces the weak handler of the startup file, the FLASH interrupt is not enabled in the
+*       CubeMX project so HAL_FLASH_IRQHandler is not used. Runs from RAM like the erase it starts.
+*       A page that failed to erase is left to the inline erase of the write.
+*/
+__RAM_FUNC void FLASH_IRQHandler(void)
+{
+	FLASH->CR &= ~(FLASH_CR_PER | FLASH_CR_EOPIE | FLASH_CR_ERRIE);
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+
+	erase_ahead.busy = 0;
+	BL_Flash_Erase_Ahead_Next();
+}
@@ -0,0 +1,40 @@
+/*
+ * bl_flash.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_FLASH_H_
+#define BL_FLASH_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+// part of a flash image kept in SRAM
+typedef struct {
+	const uint8_t *data;
+	uint32_t length;
+}BL_Flash_Segment;
+
+/*
+* ===============================================
+* APIs Supported by "BL Flash"
+* ===============================================
+*/
+BL_Status BL_Flash_Unlock(void);
+void BL_Flash_Lock(void);
+BL_Status BL_Flash_Program(uint32_t address, const uint8_t *data, uint32_t length);
+BL_Status BL_Flash_Program_In_Place(uint32_t address, const uint8_t *data, uint32_t length);
+BL_Status BL_Flash_Erase_Page(uint32_t address);
+void BL_Flash_Erase_Ahead_Start(uint8_t start_page, uint8_t number_of_pages);
+void BL_Flash_Erase_Ahead_Pause(uint8_t page_number);
+void BL_Flash_Erase_Ahead_Resume(void);
+void BL_Flash_Erase_Ahead_Stop(void);
+void BL_Flash_Mass_Erase(const BL_Flash_Segment *bootloader_copy, uint8_t number_of_segments);
+
+
+#endif /* BL_FLASH_H_ */
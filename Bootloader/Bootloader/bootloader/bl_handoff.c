@@ -0,0 +1,90 @@
+/*
+ * bl_handoff.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_handoff.h"
+#include "bl_uart.h"
+
+
+//===============================================
+//Global Variables
+//===============================================
+// placed at BL_BOOT_INFO_ADDRESS by the linker script, never initialized by the startup code
+static BL_Boot_Info BL_Boot_Info_Block __attribute__((section(".boot_info")));
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Handoff_Init
+* @brief - Starts the cycle counter unless it runs already and takes the reset cause, first thing in main.
+* @param [in] - None
+* @retval - None
+* Note- The DWT cycle counter runs without a debugger once trace is enabled. Stage 0 starts it at
+*       reset, it then keeps counting so handoff_cycles include the time spent in stage 0. The reset
+*       flags are cleared, so the next reset reports its own cause. The block is marked invalid until
+*       the jump, an application started without the bootloader then finds no magic.
+*/
+void BL_Handoff_Init(void)
+{
+	if(!(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) || !(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	BL_Boot_Info_Block.magic = 0;
+	BL_Boot_Info_Block.reset_cause = RCC->CSR & (RCC_CSR_PINRSTF | RCC_CSR_PORRSTF | RCC_CSR_SFTRSTF |
+	                                             RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF | RCC_CSR_LPWRRSTF);
+	RCC->CSR |= RCC_CSR_RMVF;
+}
+
+/**================================================================
+* @Fn- BL_Handoff_Prepare
+* @brief - Writes the boot info block and clears the interrupt state, last thing before the jump.
+* @param [in] - uint8_t boot_reason: BL_BOOT_REASON_...
+* @param [in] - uint8_t slot: Slot started, BL_BOOT_INFO_NO_SLOT otherwise
+* @param [in] - uint32_t image_CRC: CRC of the image checked before the jump, 0 if none was
+* @retval - None
+* Note- The peripherals must already be handed over (see Bootloader_Jump_To_Application), the
+*       block reports the clock and UART state they were left in. Every interrupt is disabled and
+*       its pending bit cleared in the NVIC, as are PendSV and SysTick, so nothing raised by the
+*       bootloader is taken through the vector table of the application.
+*/
+void BL_Handoff_Prepare(uint8_t boot_reason, uint8_t slot, uint32_t image_CRC)
+{
+	for(uint8_t i = 0; i < sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0]); i++)
+	{
+		NVIC->ICER[i] = 0xFFFFFFFF;
+		NVIC->ICPR[i] = 0xFFFFFFFF;
+	}
+	SCB->ICSR = SCB_ICSR_PENDSVCLR_Msk | SCB_ICSR_PENDSTCLR_Msk;
+	__DSB();
+	__ISB();
+
+	BL_Boot_Info_Block.version = BL_BOOT_INFO_VERSION;
+	BL_Boot_Info_Block.boot_reason = boot_reason;
+	BL_Boot_Info_Block.slot = slot;
+	BL_Boot_Info_Block.flags = 0;
+#if (BL_HANDOFF_KEEP_CLOCK == 1)
+	BL_Boot_Info_Block.flags |= BL_BOOT_INFO_CLOCK_KEPT;
+#endif
+#if (BL_HANDOFF_KEEP_UART == 1)
+	BL_Boot_Info_Block.flags |= BL_BOOT_INFO_UART_KEPT;
+	BL_Boot_Info_Block.uart_baud_rate = BL_UART_Get_Baud_Rate();
+#else
+	BL_Boot_Info_Block.uart_baud_rate = 0;
+#endif
+	BL_Boot_Info_Block.image_CRC = image_CRC;
+	BL_Boot_Info_Block.system_clock = SystemCoreClock;
+	BL_Boot_Info_Block.handoff_cycles = DWT->CYCCNT;
+	BL_Boot_Info_Block.magic = BL_BOOT_INFO_MAGIC;
+}
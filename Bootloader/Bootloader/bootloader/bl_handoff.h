@@ -0,0 +1,27 @@
+/*
+ * bl_handoff.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_HANDOFF_H_
+#define BL_HANDOFF_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+#include "bl_boot_info.h"
+
+
+/*
+* ===============================================
+* APIs Supported by "BL Handoff"
+* ===============================================
+*/
+void BL_Handoff_Init(void);
+void BL_Handoff_Prepare(uint8_t boot_reason, uint8_t slot, uint32_t image_CRC);
+
+
+#endif /* BL_HANDOFF_H_ */
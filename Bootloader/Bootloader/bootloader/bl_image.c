@@ -0,0 +1,154 @@
+/*
+ * bl_image.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_image.h"
+#include "bl_crc.h"
+#include "bl_flash.h"
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Image_Check_Header
+* @brief - Validates an image header and the placement of its image.
+* @param [in] - const BL_Image_Header *header: Header in flash
+* @param [in] - uint32_t run_header_address: Address the header has when the image runs
+* @retval - uint8_t (1 if the header is sound, 0 otherwise)
+* Note- The image has to run right after the header and fit in the flash from where it is now.
+*/
+static uint8_t BL_Image_Check_Header(const BL_Image_Header *header, uint32_t run_header_address)
+{
+	uint32_t image_address = (uint32_t)header + BL_IMAGE_HEADER_SIZE;
+	uint8_t valid = 0;
+
+	if(header->magic == BL_IMAGE_MAGIC &&
+	   header->header_CRC == BL_CRC_Calculate((const uint8_t *)header, offsetof(BL_Image_Header, header_CRC)) &&
+	   header->load_address == run_header_address + BL_IMAGE_HEADER_SIZE &&
+	   header->image_length > 0 && header->image_length <= (FLASH_BASE + FLASH_SIZE) - image_address)
+	{
+		valid = 1;
+	}
+
+	return valid;
+}
+
+/**================================================================
+* @Fn- BL_Image_Set_Marker
+* @brief - Programs the validity marker of a header.
+* @param [in] - const BL_Image_Header *header: Header in flash
+* @param [in] - uint32_t marker: BL_IMAGE_VALID or BL_IMAGE_INVALID
+* @retval - None
+* Note- The marker can be programmed without an erase: BL_IMAGE_VALID over the erased word,
+*       BL_IMAGE_INVALID (all zero) over any value. Programmed from the flash, the service table
+*       reaches it from the application.
+*/
+static void BL_Image_Set_Marker(const BL_Image_Header *header, uint32_t marker)
+{
+	if(BL_Flash_Unlock() == BL_OK)
+	{
+		BL_Flash_Program_In_Place((uint32_t)&header->valid_marker, (const uint8_t *)&marker, sizeof(marker));
+	}
+	BL_Flash_Lock();
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Image_Check
+* @brief - Validates the header at an address and the image it describes.
+* @param [in] - uint32_t header_address: Address of the image header
+* @param [in] - uint8_t cache_result: 1 to program BL_IMAGE_VALID into the header after a full check
+* @retval - BL_Status (BL_OK if the header and the image are valid, BL_Error otherwise)
+* Note- The header is checked against its own CRC and has to place the image right after it in
+*       the flash. A header marked BL_IMAGE_VALID skips the image CRC, otherwise the CRC of the
+*       whole image is computed by the CRC unit fed by DMA. Caching the result saves that scan on
+*       the next boots, it lasts until a page of the image is written or erased.
+*/
+BL_Status BL_Image_Check(uint32_t header_address, uint8_t cache_result)
+{
+	BL_Status bl_status = BL_Error;
+	const BL_Image_Header *header = (const BL_Image_Header *)header_address;
+
+	if(BL_Image_Check_Header(header, header_address))
+	{
+		if(header->valid_marker == BL_IMAGE_VALID)
+		{
+			bl_status = BL_OK;
+		}else if(BL_CRC_Calculate((const uint8_t *)header->load_address, header->image_length) == header->image_CRC)
+		{
+			if(cache_result && header->valid_marker == 0xFFFFFFFF)
+			{
+				BL_Image_Set_Marker(header, BL_IMAGE_VALID);
+			}
+			bl_status = BL_OK;
+		}
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Image_Check_Staged
+* @brief - Validates an image staged at one address to run at another one.
+* @param [in] - uint32_t header_address: Address of the staged image header
+* @param [in] - uint32_t run_header_address: Address its header gets once the image is swapped in
+* @retval - BL_Status (BL_OK if the header and the image are valid, BL_Error otherwise)
+* Note- Same checks as BL_Image_Check, except that the image is linked for run_header_address.
+*       The CRC is always computed, nothing is cached since the swap moves the header anyway.
+*/
+BL_Status BL_Image_Check_Staged(uint32_t header_address, uint32_t run_header_address)
+{
+	BL_Status bl_status = BL_Error;
+	const BL_Image_Header *header = (const BL_Image_Header *)header_address;
+
+	if(BL_Image_Check_Header(header, run_header_address) &&
+	   BL_CRC_Calculate((const uint8_t *)(header_address + BL_IMAGE_HEADER_SIZE), header->image_length) == header->image_CRC)
+	{
+		bl_status = BL_OK;
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Image_Invalidate
+* @brief - Drops the cached validity of an image before some of its pages change.
+* @param [in] - uint32_t header_address: Address of the image header
+* @param [in] - uint8_t start_page: First page about to be written or erased
+* @param [in] - uint8_t number_of_pages: Number of pages
+* @retval - None
+* Note- Only an image marked BL_IMAGE_VALID and overlapping the pages is touched, its marker is
+*       programmed to BL_IMAGE_INVALID so the next check computes the image CRC again. Writing the
+*       header page itself brings the marker back to erased. The flash must not be busy with the
+*       erase-ahead.
+*/
+void BL_Image_Invalidate(uint32_t header_address, uint8_t start_page, uint8_t number_of_pages)
+{
+	const BL_Image_Header *header = (const BL_Image_Header *)header_address;
+
+	if(header->valid_marker == BL_IMAGE_VALID)
+	{
+		// a marked header passed its checks, so its image length is sane
+		uint32_t image_end = header->load_address + header->image_length;
+		uint32_t pages_start = FLASH_BASE + start_page * PAGE_SIZE;
+		uint32_t pages_end = pages_start + number_of_pages * PAGE_SIZE;
+
+		if(pages_start < image_end && pages_end > header_address)
+		{
+			BL_Image_Set_Marker(header, BL_IMAGE_INVALID);
+		}
+	}
+}
@@ -0,0 +1,27 @@
+/*
+ * bl_image.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_IMAGE_H_
+#define BL_IMAGE_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+#include "bl_services.h"     // BL_Image_Header, shared with the applications
+
+/*
+* ===============================================
+* APIs Supported by "BL Image"
+* ===============================================
+*/
+BL_Status BL_Image_Check(uint32_t header_address, uint8_t cache_result);
+BL_Status BL_Image_Check_Staged(uint32_t header_address, uint32_t run_header_address);
+void BL_Image_Invalidate(uint32_t header_address, uint8_t start_page, uint8_t number_of_pages);
+
+
+#endif /* BL_IMAGE_H_ */
@@ -0,0 +1,241 @@
+/*
+ * bl_services.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_services.h"
+#include "bl_flash.h"
+#include "bl_crc.h"
+#include "bl_image.h"
+#include "bl_slot.h"
+#include "bl_swap.h"
+
+
+/*
+* ===============================================
+* Helper functions Prototypes
+* ===============================================
+*/
+static uint8_t BL_Services_Flash_Program_Page(uint8_t page_number, const uint8_t *data, uint16_t length);
+static uint8_t BL_Services_Flash_Erase(uint8_t start_page, uint8_t number_of_pages);
+static uint32_t BL_Services_CRC32_DMA(const uint8_t *data, uint32_t length);
+static uint8_t BL_Services_Image_Header_Read(uint8_t slot, BL_Image_Header *header);
+static uint8_t BL_Services_Swap_Request(uint8_t number_of_pages, uint32_t image_CRC);
+
+
+//===============================================
+//Global Variables
+//===============================================
+// placed at BL_SERVICES_ADDRESS by the linker script, new services only go at the end
+static const BL_Services BL_Services_Table __attribute__((section(".bl_services"), used)) = {
+	.magic = BL_SERVICES_MAGIC,
+	.version = BL_SERVICES_VERSION,
+	.size = sizeof(BL_Services),
+	.flash_program_page = BL_Services_Flash_Program_Page,
+	.flash_erase = BL_Services_Flash_Erase,
+	.crc32_dma = BL_Services_CRC32_DMA,
+	.image_header_read = BL_Services_Image_Header_Read,
+	.swap_request = BL_Services_Swap_Request,
+};
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Services_Pages_Allowed
+* @brief - Checks that an application may write or erase a page range.
+* @param [in] - uint8_t start_page: First page of the range
+* @param [in] - uint8_t number_of_pages: Number of pages in the range
+* @retval - uint8_t (1 if the range lies in the slots or the free page, 0 otherwise)
+* Note- The same pages as for the host commands: the bootloader, the swap journal and the slot
+*       metadata are never touched by a flash service.
+*/
+static uint8_t BL_Services_Pages_Allowed(uint8_t start_page, uint8_t number_of_pages)
+{
+	return (start_page >= BL_SLOT_A_PAGE && number_of_pages <= BL_HOST_PAGE_END - start_page) ? 1 : 0;
+}
+
+/**================================================================
+* @Fn- BL_Services_Invalidate_Images
+* @brief - Drops the cached validity of the slot images overlapping some pages.
+* @param [in] - uint8_t start_page: First page about to be written or erased
+* @param [in] - uint8_t number_of_pages: Number of pages
+* @retval - None
+* Note- Keeps the rule of the bootloader commands: no marked image changes without losing its marker.
+*/
+static void BL_Services_Invalidate_Images(uint8_t start_page, uint8_t number_of_pages)
+{
+	for(uint8_t slot = 0; slot < BL_NUMBER_OF_SLOTS; slot++)
+	{
+		BL_Image_Invalidate(BL_Slot_Header_Address(slot), start_page, number_of_pages);
+	}
+}
+
+/**================================================================
+* @Fn- BL_Services_Flash_Program_Page
+* @brief - Writes data to a flash page, service flash_program_page.
+* @param [in] - uint8_t page_number: Page to write
+* @param [in] - const uint8_t *data: Data to write from the start of the page
+* @param [in] - uint16_t length: Number of bytes, up to PAGE_SIZE, the rest of the page ends up erased
+* @retval - uint8_t (BL_SERVICE_OK if the page reads back as written, BL_SERVICE_ERROR otherwise)
+* Note- Like Flash_Memory_Write_Page of the bootloader: the page is only erased when a halfword to
+*       change is not erased, and a page already holding the data is not touched. The programming
+*       runs from the flash (BL_Flash_Program_In_Place), so the CPU stalls during each halfword.
+*/
+static uint8_t BL_Services_Flash_Program_Page(uint8_t page_number, const uint8_t *data, uint16_t length)
+{
+	uint8_t result = BL_SERVICE_OK;
+	uint32_t address = FLASH_BASE + page_number * PAGE_SIZE;
+	uint8_t page_changed = 0;
+	uint8_t erase_needed = 0;
+
+	if(length > PAGE_SIZE || !BL_Services_Pages_Allowed(page_number, 1))
+	{
+		return BL_SERVICE_ERROR;
+	}
+
+	for(uint16_t offset = 0; offset < PAGE_SIZE; offset += 2)
+	{
+		uint16_t flash_halfword = *((volatile uint16_t *)(address + offset));
+		uint8_t low = (offset < length) ? data[offset] : 0xFF;
+		uint8_t high = (offset + 1 < length) ? data[offset + 1] : 0xFF;
+
+		if(flash_halfword != (uint16_t)(low | (high << 8)))
+		{
+			page_changed = 1;
+			if(flash_halfword != 0xFFFF)
+			{
+				erase_needed = 1;
+				break;
+			}
+		}
+	}
+
+	if(page_changed)
+	{
+		BL_Services_Invalidate_Images(page_number, 1);
+
+		if(BL_Flash_Unlock() != BL_OK || (erase_needed && BL_Flash_Erase_Page(address) != BL_OK) ||
+		   BL_Flash_Program_In_Place(address, data, length) != BL_OK)
+		{
+			result = BL_SERVICE_ERROR;
+		}
+		BL_Flash_Lock();
+	}
+
+	return result;
+}
+
+/**================================================================
+* @Fn- BL_Services_Flash_Erase
+* @brief - Erases a page range, service flash_erase.
+* @param [in] - uint8_t start_page: First page of the range
+* @param [in] - uint8_t number_of_pages: Number of pages in the range
+* @retval - uint8_t (BL_SERVICE_OK if every page erased without error flag, BL_SERVICE_ERROR otherwise)
+* Note- Pages already erased are skipped, as by the erase-ahead of the bootloader.
+*/
+static uint8_t BL_Services_Flash_Erase(uint8_t start_page, uint8_t number_of_pages)
+{
+	uint8_t result = BL_SERVICE_OK;
+
+	if(!BL_Services_Pages_Allowed(start_page, number_of_pages))
+	{
+		return BL_SERVICE_ERROR;
+	}
+
+	BL_Services_Invalidate_Images(start_page, number_of_pages);
+
+	if(BL_Flash_Unlock() != BL_OK)
+	{
+		result = BL_SERVICE_ERROR;
+	}
+
+	for(uint8_t page = start_page; result == BL_SERVICE_OK && page < start_page + number_of_pages; page++)
+	{
+		const uint32_t *word = (const uint32_t *)(FLASH_BASE + page * PAGE_SIZE);
+		uint16_t i = 0;
+
+		while(i < PAGE_SIZE / 4 && word[i] == 0xFFFFFFFF)
+		{
+			i++;
+		}
+
+		if(i < PAGE_SIZE / 4 && BL_Flash_Erase_Page((uint32_t)word) != BL_OK)
+		{
+			result = BL_SERVICE_ERROR;
+		}
+	}
+	BL_Flash_Lock();
+
+	return result;
+}
+
+/**================================================================
+* @Fn- BL_Services_CRC32_DMA
+* @brief - Computes the STM32 CRC-32 of a buffer, service crc32_dma.
+* @param [in] - const uint8_t *data: Buffer to compute the CRC of
+* @param [in] - uint32_t length: Number of bytes in the buffer
+* @retval - uint32_t (CRC-32 as BL_CRC_Calculate)
+* Note- The clocks of the CRC unit and DMA1 are enabled and left on. DMA1 channel 1 is used for
+*       aligned buffers of BL_CRC_DMA_MIN_WORDS words or more, the application must not use it at
+*       the same time.
+*/
+static uint32_t BL_Services_CRC32_DMA(const uint8_t *data, uint32_t length)
+{
+	RCC->AHBENR |= RCC_AHBENR_CRCEN | RCC_AHBENR_DMA1EN;
+
+	return BL_CRC_Calculate(data, length);
+}
+
+/**================================================================
+* @Fn- BL_Services_Image_Header_Read
+* @brief - Copies the image header of a slot and checks it, service image_header_read.
+* @param [in] - uint8_t slot: BL_SLOT_A or BL_SLOT_B
+* @param [out] - BL_Image_Header *header: Copy of the header, left untouched for an unknown slot
+* @retval - uint8_t (BL_SERVICE_OK if the header and its image pass BL_Image_Check, BL_SERVICE_ERROR otherwise)
+* Note- The check does not program the validity marker. The image CRC is computed as by
+*       BL_Services_CRC32_DMA unless the header is already marked valid.
+*/
+static uint8_t BL_Services_Image_Header_Read(uint8_t slot, BL_Image_Header *header)
+{
+	uint32_t header_address;
+
+	if(slot >= BL_NUMBER_OF_SLOTS)
+	{
+		return BL_SERVICE_ERROR;
+	}
+
+	header_address = BL_Slot_Header_Address(slot);
+	memcpy(header, (const void *)header_address, sizeof(BL_Image_Header));
+	RCC->AHBENR |= RCC_AHBENR_CRCEN | RCC_AHBENR_DMA1EN;
+
+	return (BL_Image_Check(header_address, 0) == BL_OK) ? BL_SERVICE_OK : BL_SERVICE_ERROR;
+}
+
+/**================================================================
+* @Fn- BL_Services_Swap_Request
+* @brief - Writes a swap request into the journal, service swap_request.
+* @param [in] - uint8_t number_of_pages: Pages swapped from the start of each slot, header included
+* @param [in] - uint32_t image_CRC: Image CRC in the header of the image staged in slot B
+* @retval - uint8_t (BL_SERVICE_OK if the request was programmed, BL_SERVICE_ERROR otherwise)
+* Note- The journal page is reserved to bl_swap.c, the application asks for the swap here instead
+*       of programming it. The swap runs at the next reset. A pending request is not replaced, its
+*       progress would be lost. The staged image is checked by the bootloader before the first step.
+*/
+static uint8_t BL_Services_Swap_Request(uint8_t number_of_pages, uint32_t image_CRC)
+{
+	RCC->AHBENR |= RCC_AHBENR_CRCEN | RCC_AHBENR_DMA1EN;
+
+	if(number_of_pages == 0 || number_of_pages > BL_SWAP_MAX_PAGES || BL_Swap_Get_Request() != NULL)
+	{
+		return BL_SERVICE_ERROR;
+	}
+
+	return (BL_Swap_Set_Request(number_of_pages, image_CRC) == BL_OK) ? BL_SERVICE_OK : BL_SERVICE_ERROR;
+}
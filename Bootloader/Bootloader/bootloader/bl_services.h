@@ -0,0 +1,68 @@
+/*
+ * bl_services.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  Service table the bootloader exports at a fixed address, so applications use its
+ *  flash, CRC and image header code instead of linking their own. The header only
+ *  needs stdint.h, so applications can include it as it is.
+ */
+
+#ifndef BL_SERVICES_H_
+#define BL_SERVICES_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include <stdint.h>
+
+
+//-----------------------------
+// Service Table
+//-----------------------------
+// @brief Address of the table, right after the bootloader vector table: it stays there across bootloader builds.
+#define BL_SERVICES_ADDRESS    0x08000200
+// @brief First word of the table ("SERV").
+#define BL_SERVICES_MAGIC      0x56524553
+// @brief Table version, raised when services are added at the end.
+#define BL_SERVICES_VERSION             2
+
+// @brief Service results.
+#define BL_SERVICE_OK                   0
+#define BL_SERVICE_ERROR                1
+
+// header at the start of an application region, the vector table follows at load_address
+typedef struct {
+	uint32_t magic;             // BL_IMAGE_MAGIC
+	uint32_t load_address;      // vector table, BL_IMAGE_HEADER_SIZE after the header
+	uint32_t image_length;      // bytes from load_address on
+	uint32_t image_CRC;         // STM32 CRC-32 of those bytes
+	uint8_t version_major;
+	uint8_t version_minor;
+	uint16_t version_patch;
+	uint32_t build_id;
+	uint32_t header_CRC;        // STM32 CRC-32 of the fields above
+	uint32_t valid_marker;      // erased, BL_IMAGE_VALID or BL_IMAGE_INVALID, written by the bootloader
+}BL_Image_Header;
+
+// table at BL_SERVICES_ADDRESS, the services run in the caller context and use no bootloader variable
+typedef struct {
+	uint32_t magic;             // BL_SERVICES_MAGIC, anything else: no bootloader with services
+	uint16_t version;           // BL_SERVICES_VERSION of the bootloader
+	uint16_t size;              // sizeof(BL_Services) of the bootloader, services past it are missing
+
+	// writes a page the way BL_MEM_WRITE_CMD does: erased only when needed, unchanged halfwords skipped
+	uint8_t (*flash_program_page)(uint8_t page_number, const uint8_t *data, uint16_t length);
+	// erases a page range, pages already erased are skipped
+	uint8_t (*flash_erase)(uint8_t start_page, uint8_t number_of_pages);
+	// STM32 CRC-32 of a buffer, on the CRC unit fed by DMA1 channel 1
+	uint32_t (*crc32_dma)(const uint8_t *data, uint32_t length);
+	// copies the image header of a slot, BL_SERVICE_OK if the header and its image are valid
+	uint8_t (*image_header_read)(uint8_t slot, BL_Image_Header *header);
+	// version 2: requests the swap of the image staged in slot B at the next reset, see BL_SWAP_CMD
+	uint8_t (*swap_request)(uint8_t number_of_pages, uint32_t image_CRC);
+}BL_Services;
+
+
+#endif /* BL_SERVICES_H_ */
@@ -0,0 +1,182 @@
+/*
+ * bl_slot.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_slot.h"
+#include "bl_crc.h"
+#include "bl_flash.h"
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Slot_Record_Valid
+* @brief - Checks a record of the metadata pages.
+* @param [in] - const BL_Slot_Record *record: Record in flash
+* @retval - uint8_t (1 if the record is complete and names a slot, 0 otherwise)
+* Note- A record torn by a reset during its programming fails the CRC.
+*/
+static uint8_t BL_Slot_Record_Valid(const BL_Slot_Record *record)
+{
+	uint8_t valid = 0;
+
+	if(record->magic == BL_SLOT_RECORD_MAGIC && record->active_slot < BL_NUMBER_OF_SLOTS &&
+	   record->record_CRC == BL_CRC_Calculate((const uint8_t *)record, offsetof(BL_Slot_Record, record_CRC)))
+	{
+		valid = 1;
+	}
+
+	return valid;
+}
+
+/**================================================================
+* @Fn- BL_Slot_Current_Record
+* @brief - Finds the valid record with the highest sequence number in the metadata pages.
+* @param [in] - None
+* @retval - const BL_Slot_Record * (The current record, NULL if there is none)
+*/
+static const BL_Slot_Record *BL_Slot_Current_Record(void)
+{
+	const BL_Slot_Record *current = NULL;
+	const BL_Slot_Record *record = (const BL_Slot_Record *)(FLASH_BASE + BL_SLOT_META_PAGE * PAGE_SIZE);
+	const BL_Slot_Record *records_end = record + (BL_SLOT_META_PAGES * PAGE_SIZE) / sizeof(BL_Slot_Record);
+
+	for(; record < records_end; record++)
+	{
+		if(BL_Slot_Record_Valid(record) && (current == NULL || record->sequence > current->sequence))
+		{
+			current = record;
+		}
+	}
+
+	return current;
+}
+
+/**================================================================
+* @Fn- BL_Slot_Record_Erased
+* @brief - Checks whether a record place in the metadata pages was never programmed.
+* @param [in] - const BL_Slot_Record *record: Record place in flash
+* @retval - uint8_t (1 if all its words are erased, 0 otherwise)
+*/
+static uint8_t BL_Slot_Record_Erased(const BL_Slot_Record *record)
+{
+	const uint32_t *word = (const uint32_t *)record;
+	uint8_t erased = 1;
+
+	for(uint8_t i = 0; i < sizeof(BL_Slot_Record) / 4; i++)
+	{
+		if(word[i] != 0xFFFFFFFF)
+		{
+			erased = 0;
+		}
+	}
+
+	return erased;
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Slot_Get_Active
+* @brief - Returns the slot the application is started from.
+* @param [in] - None
+* @retval - uint8_t (BL_SLOT_A or BL_SLOT_B)
+* Note- Without a valid record, after a mass erase for instance, slot A is active.
+*/
+uint8_t BL_Slot_Get_Active(void)
+{
+	const BL_Slot_Record *current = BL_Slot_Current_Record();
+
+	return (current != NULL) ? (uint8_t)current->active_slot : BL_SLOT_A;
+}
+
+/**================================================================
+* @Fn- BL_Slot_Set_Active
+* @brief - Makes a slot the one the application is started from.
+* @param [in] - uint8_t slot: BL_SLOT_A or BL_SLOT_B
+* @retval - BL_Status (BL_OK if the new record reads back, BL_Error otherwise)
+* Note- The metadata pages are an append-only log of records, a switch programs one record after the
+*       current one. A reset while it is programmed leaves a record failing its CRC and the previous
+*       one stays current, so the switch is atomic. When the page of the current record is full, the
+*       other page, holding older records only, is erased and the record goes to its start.
+*       The flash must not be busy with the erase-ahead.
+*/
+BL_Status BL_Slot_Set_Active(uint8_t slot)
+{
+	BL_Status bl_status = BL_Error;
+	const BL_Slot_Record *current = BL_Slot_Current_Record();
+	uint32_t meta_start = FLASH_BASE + BL_SLOT_META_PAGE * PAGE_SIZE;
+	uint32_t page_start = (current != NULL) ? ((uint32_t)current & ~(uint32_t)(PAGE_SIZE - 1)) : meta_start;
+	const BL_Slot_Record *place = (current != NULL) ? current + 1 : (const BL_Slot_Record *)page_start;
+	BL_Slot_Record record;
+
+	if(slot >= BL_NUMBER_OF_SLOTS)
+	{
+		return BL_Error;
+	}
+
+	record.magic = BL_SLOT_RECORD_MAGIC;
+	record.sequence = (current != NULL) ? current->sequence + 1 : 1;
+	record.active_slot = slot;
+	record.record_CRC = BL_CRC_Calculate((const uint8_t *)&record, offsetof(BL_Slot_Record, record_CRC));
+
+	// skip the places written by an interrupted switch
+	while((uint32_t)place < page_start + PAGE_SIZE && !BL_Slot_Record_Erased(place))
+	{
+		place++;
+	}
+
+	if(BL_Flash_Unlock() == BL_OK)
+	{
+		bl_status = BL_OK;
+		if((uint32_t)place >= page_start + PAGE_SIZE)
+		{
+			// BL_SLOT_META_PAGES is two, the records go on in the other page
+			page_start = (page_start == meta_start) ? meta_start + PAGE_SIZE : meta_start;
+			place = (const BL_Slot_Record *)page_start;
+			bl_status = BL_Flash_Erase_Page(page_start);
+		}
+
+		if(bl_status == BL_OK)
+		{
+			bl_status = BL_Flash_Program((uint32_t)place, (const uint8_t *)&record, sizeof(record));
+		}
+	}
+	BL_Flash_Lock();
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Slot_First_Page
+* @brief - Returns the first flash page of a slot, the page holding its image header.
+* @param [in] - uint8_t slot: BL_SLOT_A or BL_SLOT_B
+* @retval - uint8_t (Page number)
+*/
+uint8_t BL_Slot_First_Page(uint8_t slot)
+{
+	return (slot == BL_SLOT_B) ? BL_SLOT_B_PAGE : BL_SLOT_A_PAGE;
+}
+
+/**================================================================
+* @Fn- BL_Slot_Header_Address
+* @brief - Returns the address of the image header of a slot.
+* @param [in] - uint8_t slot: BL_SLOT_A or BL_SLOT_B
+* @retval - uint32_t (Header address, the vector table is BL_IMAGE_HEADER_SIZE further)
+*/
+uint32_t BL_Slot_Header_Address(uint8_t slot)
+{
+	return FLASH_BASE + BL_Slot_First_Page(slot) * PAGE_SIZE;
+}
@@ -0,0 +1,36 @@
+/*
+ * bl_slot.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_SLOT_H_
+#define BL_SLOT_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+// record appended to the metadata pages each time the active slot changes
+typedef struct {
+	uint32_t magic;             // BL_SLOT_RECORD_MAGIC
+	uint32_t sequence;          // one more than the record before, the highest valid one is current
+	uint32_t active_slot;       // BL_SLOT_A or BL_SLOT_B
+	uint32_t record_CRC;        // STM32 CRC-32 of the fields above
+}BL_Slot_Record;
+
+/*
+* ===============================================
+* APIs Supported by "BL Slot"
+* ===============================================
+*/
+uint8_t BL_Slot_Get_Active(void);
+BL_Status BL_Slot_Set_Active(uint8_t slot);
+uint8_t BL_Slot_First_Page(uint8_t slot);
+uint32_t BL_Slot_Header_Address(uint8_t slot);
+
+
+#endif /* BL_SLOT_H_ */
@@ -0,0 +1,253 @@
+/*
+ * bl_stage0.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_stage0.h"
+#include "bl_boot_info.h"
+#include "bl_image.h"
+#include "bl_slot.h"
+
+/*
+ * Stage 0 is the code run at reset, in the first flash page with its own vector table. It starts the
+ * active slot when its image is already marked valid and nothing asks for the bootloader. Otherwise it
+ * hands over to stage 1, the CubeMX startup code and everything else of the bootloader.
+ * It runs before .data and .bss are set up: no variable and no function outside stage 0 may be used.
+ */
+
+
+/*
+* ===============================================
+* Helper functions Prototypes
+* ===============================================
+*/
+static void BL_Stage0_Fault_Handler(void);
+
+
+//===============================================
+//Global Variables
+//===============================================
+extern uint32_t _estack;
+extern uint32_t g_pfnVectors[];     // stage 1 vector table (startup code)
+
+// vector table at reset, a fault in stage 0 ends in BL_Stage0_Fault_Handler
+static const void *const BL_Stage0_Vectors[] __attribute__((section(".stage0_vectors"), used)) = {
+	&_estack,
+	(void *)BL_Stage0_Reset_Handler,
+	(void *)BL_Stage0_Fault_Handler,    // NMI
+	(void *)BL_Stage0_Fault_Handler,    // HardFault
+};
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Stage0_Fault_Handler
+* @brief - NMI and HardFault handler while stage 0 runs.
+* @param [in] - None
+* @retval - None
+*/
+static BL_STAGE0_FUNC void BL_Stage0_Fault_Handler(void)
+{
+	while(1);
+}
+
+/**================================================================
+* @Fn- BL_Stage0_CRC
+* @brief - Computes the STM32 CRC-32 of whole words with the CPU.
+* @param [in] - const uint32_t *word: First word
+* @param [in] - uint32_t number_of_words: Number of words
+* @retval - uint32_t (CRC-32 as BL_CRC_Calculate)
+* Note- The CRC clock must be enabled.
+*/
+static BL_STAGE0_FUNC uint32_t BL_Stage0_CRC(const uint32_t *word, uint32_t number_of_words)
+{
+	CRC->CR = CRC_CR_RESET;
+
+	while(number_of_words-- > 0)
+	{
+		CRC->DR = *word++;
+	}
+
+	return CRC->DR;
+}
+
+/**================================================================
+* @Fn- BL_Stage0_Boot_Requested
+* @brief - Checks whether the bootloader is asked to stay, by the application or by the boot pin.
+* @param [in] - None
+* @retval - uint8_t (1 if BL_BOOT_REQUEST_REGISTER holds a request or the boot pin is active, 0 otherwise)
+* Note- The request is left for stage 1 to read and clear. The boot pin is read in its reset state,
+*       a floating input. The clocks are turned off again.
+*/
+static BL_STAGE0_FUNC uint8_t BL_Stage0_Boot_Requested(void)
+{
+	uint8_t requested = 0;
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+
+	uint16_t magic = (uint16_t)BL_BOOT_REQUEST_REGISTER;
+
+	if(magic == BL_BOOT_REQUEST_MAGIC || magic == BL_UPDATE_REQUEST_MAGIC)
+	{
+		requested = 1;
+	}
+
+	__HAL_RCC_BKP_CLK_DISABLE();
+	__HAL_RCC_PWR_CLK_DISABLE();
+
+#if (BL_BOOT_PIN_ENABLE == 1)
+	uint32_t apb2_clocks = RCC->APB2ENR;
+
+	BL_BOOT_PIN_CLK_ENABLE();
+	if(((BL_BOOT_PIN_PORT->IDR & BL_BOOT_PIN) ? GPIO_PIN_SET : GPIO_PIN_RESET) == BL_BOOT_PIN_ACTIVE)
+	{
+		requested = 1;
+	}
+	RCC->APB2ENR = apb2_clocks;
+#endif
+
+	return requested;
+}
+
+/**================================================================
+* @Fn- BL_Stage0_Active_Slot
+* @brief - Finds the active slot in the slot metadata records.
+* @param [in] - None
+* @retval - uint8_t (BL_SLOT_A or BL_SLOT_B)
+* Note- Same rules as BL_Slot_Get_Active: the valid record with the highest sequence wins, slot A
+*       is active without one. The CRC clock must be enabled.
+*/
+static BL_STAGE0_FUNC uint8_t BL_Stage0_Active_Slot(void)
+{
+	const BL_Slot_Record *record = (const BL_Slot_Record *)(FLASH_BASE + BL_SLOT_META_PAGE * PAGE_SIZE);
+	const BL_Slot_Record *records_end = record + (BL_SLOT_META_PAGES * PAGE_SIZE) / sizeof(BL_Slot_Record);
+	uint32_t sequence = 0;
+	uint8_t active_slot = BL_SLOT_A;
+
+	for(; record < records_end; record++)
+	{
+		if(record->magic == BL_SLOT_RECORD_MAGIC && record->active_slot < BL_NUMBER_OF_SLOTS &&
+		   record->sequence > sequence &&
+		   record->record_CRC == BL_Stage0_CRC((const uint32_t *)record, offsetof(BL_Slot_Record, record_CRC) / 4))
+		{
+			sequence = record->sequence;
+			active_slot = (uint8_t)record->active_slot;
+		}
+	}
+
+	return active_slot;
+}
+
+/**================================================================
+* @Fn- BL_Stage0_Check_Slot
+* @brief - Checks that the image of a slot can be started without stage 1.
+* @param [in] - uint32_t header_address: Address of the image header of the slot
+* @retval - uint32_t (Address of the vector table, 0 if stage 1 has to check the slot)
+* Note- Only a header marked BL_IMAGE_VALID is accepted, the marker is only programmed after a full
+*       check of the image CRC by stage 1, so the image is not scanned here. Its vector table is
+*       checked as by Bootloader_Application_Valid. The CRC clock must be enabled.
+*/
+static BL_STAGE0_FUNC uint32_t BL_Stage0_Check_Slot(uint32_t header_address)
+{
+	const BL_Image_Header *header = (const BL_Image_Header *)header_address;
+	uint32_t address = header_address + BL_IMAGE_HEADER_SIZE;
+	uint32_t stack_pointer = *((const uint32_t *)address);
+	uint32_t reset_handler = *((const uint32_t *)(address + 4));
+
+	if(header->magic == BL_IMAGE_MAGIC && header->valid_marker == BL_IMAGE_VALID && header->load_address == address &&
+	   header->header_CRC == BL_Stage0_CRC((const uint32_t *)header, offsetof(BL_Image_Header, header_CRC) / 4) &&
+	   stack_pointer > SRAM_BASE && stack_pointer <= (SRAM_BASE + SRAM_SIZE) && (stack_pointer & 0x3) == 0 &&
+	   (reset_handler & 0x1) && reset_handler > address && reset_handler < (FLASH_BASE + FLASH_SIZE))
+	{
+		return address;
+	}
+
+	return 0;
+}
+
+/**================================================================
+* @Fn- BL_Stage0_Jump
+* @brief - Starts the code whose vector table is at an address.
+* @param [in] - uint32_t address: Vector table of stage 1 or of the application
+* @retval - None
+*/
+static BL_STAGE0_FUNC void BL_Stage0_Jump(uint32_t address)
+{
+	void (*reset_handler)(void) = (void (*)(void))(*(volatile uint32_t *)(address + 4));
+
+	SCB->VTOR = address;
+	__set_MSP(*(volatile uint32_t *)address);
+
+	reset_handler();
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Stage0_Reset_Handler
+* @brief - Reset handler of the bootloader: starts the application directly or stage 1.
+* @param [in] - None
+* @retval - None
+* Note- The application is started on the reset clock, with no peripheral touched but the CRC unit,
+*       the backup registers and the boot pin port, whose clocks are turned off again. Stage 1 runs
+*       when the application or the boot pin asks for the bootloader, a swap is pending or the active
+*       image is not marked valid: it then opens the sync window, checks the image CRC, falls back to
+*       the other slot and caches the result, so the next reset takes the short path again.
+*       The application gets a boot info block as from stage 1, handoff_cycles count from reset.
+*/
+BL_STAGE0_FUNC void BL_Stage0_Reset_Handler(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if (BL_STAGE0_ENABLE == 1) && (BL_AUTOBOOT_ENABLE == 1)
+	uint32_t address = 0;
+	uint8_t slot = BL_SLOT_A;
+
+	__HAL_RCC_CRC_CLK_ENABLE();
+	// a pending swap is completed by stage 1, the request is validated there
+	if(!BL_Stage0_Boot_Requested() &&
+	   *((const uint32_t *)(FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE)) != BL_SWAP_REQUEST_MAGIC)
+	{
+		slot = BL_Stage0_Active_Slot();
+		address = BL_Stage0_Check_Slot(FLASH_BASE + ((slot == BL_SLOT_B) ? BL_SLOT_B_PAGE : BL_SLOT_A_PAGE) * PAGE_SIZE);
+	}
+	__HAL_RCC_CRC_CLK_DISABLE();
+
+	if(address != 0)
+	{
+		BL_Boot_Info *boot_info = (BL_Boot_Info *)BL_BOOT_INFO_ADDRESS;
+
+		boot_info->version = BL_BOOT_INFO_VERSION;
+		boot_info->boot_reason = BL_BOOT_REASON_AUTOBOOT;
+		boot_info->slot = slot;
+		boot_info->flags = 0;
+		boot_info->reset_cause = RCC->CSR & (RCC_CSR_PINRSTF | RCC_CSR_PORRSTF | RCC_CSR_SFTRSTF |
+		                                     RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF | RCC_CSR_LPWRRSTF);
+		boot_info->image_CRC = ((const BL_Image_Header *)(address - BL_IMAGE_HEADER_SIZE))->image_CRC;
+		boot_info->system_clock = HSI_VALUE;
+		boot_info->uart_baud_rate = 0;
+		boot_info->handoff_cycles = DWT->CYCCNT;
+		boot_info->magic = BL_BOOT_INFO_MAGIC;
+		RCC->CSR |= RCC_CSR_RMVF;
+
+		BL_Stage0_Jump(address);
+	}
+#endif
+
+	BL_Stage0_Jump((uint32_t)g_pfnVectors);
+}
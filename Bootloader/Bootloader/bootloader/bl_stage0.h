@@ -0,0 +1,25 @@
+/*
+ * bl_stage0.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_STAGE0_H_
+#define BL_STAGE0_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+/*
+* ===============================================
+* APIs Supported by "BL Stage0"
+* ===============================================
+*/
+void BL_Stage0_Reset_Handler(void);
+
+
+#endif /* BL_STAGE0_H_ */
@@ -0,0 +1,212 @@
+/*
+ * bl_swap.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_swap.h"
+#include "bl_crc.h"
+#include "bl_flash.h"
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Swap_Journal_Erased
+* @brief - Checks whether the journal page was never programmed since its last erase.
+* @param [in] - None
+* @retval - uint8_t (1 if all its words are erased, 0 otherwise)
+*/
+static uint8_t BL_Swap_Journal_Erased(void)
+{
+	const uint32_t *word = (const uint32_t *)(FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE);
+	uint8_t erased = 1;
+
+	for(uint16_t i = 0; i < PAGE_SIZE / 4; i++)
+	{
+		if(word[i] != 0xFFFFFFFF)
+		{
+			erased = 0;
+			break;
+		}
+	}
+
+	return erased;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Step_Flag
+* @brief - Returns the address of the flag of a step, the flags follow the request.
+* @param [in] - uint16_t step: Step number
+* @retval - uint32_t (Flag address in the journal page)
+*/
+static uint32_t BL_Swap_Step_Flag(uint16_t step)
+{
+	return FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE + sizeof(BL_Swap_Request) + step * sizeof(uint16_t);
+}
+
+
+/*
+* ===============================================
+* APIs
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_Swap_Get_Request
+* @brief - Returns the pending swap request, if any.
+* @param [in] - None
+* @retval - const BL_Swap_Request * (The request in the journal page, NULL if there is none)
+* Note- A request torn by a reset during its programming fails the CRC and is ignored.
+*/
+const BL_Swap_Request *BL_Swap_Get_Request(void)
+{
+	const BL_Swap_Request *request = (const BL_Swap_Request *)(FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE);
+
+	if(request->magic != BL_SWAP_REQUEST_MAGIC || request->number_of_pages == 0 ||
+	   request->number_of_pages > BL_SWAP_MAX_PAGES ||
+	   request->request_CRC != BL_CRC_Calculate((const uint8_t *)request, offsetof(BL_Swap_Request, request_CRC)))
+	{
+		request = NULL;
+	}
+
+	return request;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Set_Request
+* @brief - Writes a swap request with all its steps still to do.
+* @param [in] - uint8_t number_of_pages: Pages swapped from the start of each slot
+* @param [in] - uint32_t image_CRC: Image CRC in the header of the staged image
+* @retval - BL_Status (BL_OK if the request was programmed, BL_Error otherwise)
+* Note- The journal page is only erased if it is not already. Must not be called while a request is
+*       pending, its progress would be lost. The flash must not be busy with the erase-ahead.
+*       The few halfwords are programmed in place, so the swap_request service can call it too.
+*/
+BL_Status BL_Swap_Set_Request(uint8_t number_of_pages, uint32_t image_CRC)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t journal_address = FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE;
+	BL_Swap_Request request;
+
+	request.magic = BL_SWAP_REQUEST_MAGIC;
+	request.number_of_pages = number_of_pages;
+	request.image_CRC = image_CRC;
+	request.request_CRC = BL_CRC_Calculate((const uint8_t *)&request, offsetof(BL_Swap_Request, request_CRC));
+
+	if(BL_Flash_Unlock() == BL_OK)
+	{
+		bl_status = BL_OK;
+		if(!BL_Swap_Journal_Erased())
+		{
+			bl_status = BL_Flash_Erase_Page(journal_address);
+		}
+
+		if(bl_status == BL_OK)
+		{
+			bl_status = BL_Flash_Program_In_Place(journal_address, (const uint8_t *)&request, sizeof(request));
+		}
+	}
+	BL_Flash_Lock();
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Clear_Request
+* @brief - Drops the request once the swap is complete (or the staged image turned out invalid).
+* @param [in] - None
+* @retval - BL_Status (BL_OK if the journal page is erased, BL_Error otherwise)
+* Note- The magic is programmed to zero before the erase: an erase cut by a reset can leave the
+*       request readable with its step flags erased again, which would swap the images back.
+*/
+BL_Status BL_Swap_Clear_Request(void)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t journal_address = FLASH_BASE + BL_SWAP_JOURNAL_PAGE * PAGE_SIZE;
+	uint32_t cleared_magic = 0;
+
+	if(BL_Flash_Unlock() == BL_OK &&
+	   BL_Flash_Program(journal_address, (const uint8_t *)&cleared_magic, sizeof(cleared_magic)) == BL_OK)
+	{
+		bl_status = BL_Flash_Erase_Page(journal_address);
+	}
+	BL_Flash_Lock();
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Step_Done
+* @brief - Tells whether a step of the pending swap was completed.
+* @param [in] - uint16_t step: Step number, below BL_SWAP_STEPS(number_of_pages)
+* @retval - uint8_t (1 if done, 0 otherwise)
+* Note- A flag torn by a reset during its programming is neither erased nor zero, the step is
+*       done again: each step copies a page whose source is still intact, so redoing it is safe.
+*/
+uint8_t BL_Swap_Step_Done(uint16_t step)
+{
+	return (*((volatile const uint16_t *)BL_Swap_Step_Flag(step)) == BL_SWAP_STEP_DONE) ? 1 : 0;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Set_Step_Done
+* @brief - Records in the journal that a step of the pending swap is complete.
+* @param [in] - uint16_t step: Step number, below BL_SWAP_STEPS(number_of_pages)
+* @retval - BL_Status (BL_OK if the flag was programmed, BL_Error otherwise)
+* Note- Zero can be programmed over a torn flag, no erase is needed until the swap is over.
+*/
+BL_Status BL_Swap_Set_Step_Done(uint16_t step)
+{
+	BL_Status bl_status = BL_Error;
+	uint16_t done = BL_SWAP_STEP_DONE;
+
+	if(BL_Flash_Unlock() == BL_OK)
+	{
+		bl_status = BL_Flash_Program(BL_Swap_Step_Flag(step), (const uint8_t *)&done, sizeof(done));
+	}
+	BL_Flash_Lock();
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_Swap_Step_Pages
+* @brief - Returns the page copy a step of the swap is made of.
+* @param [in] - uint16_t step: Step number, below BL_SWAP_STEPS(number_of_pages)
+* @param [in] - uint8_t number_of_pages: Pages swapped from the start of each slot
+* @param [out] - uint8_t *source_page: Page copied
+* @param [out] - uint8_t *destination_page: Page written
+* @retval - None
+* Note- The first steps move the primary image of slot A up by one page, from its last page down,
+*       into the page slot A keeps free. Then for each page i, the staged page B[i] goes to A[i] and
+*       the moved primary page A[i + 1] goes to B[i]. Every source is intact until its step is done,
+*       and each page is erased at most once per phase instead of once per page through a single
+*       scratch page, which would wear out after a few hundred swaps.
+*/
+void BL_Swap_Step_Pages(uint16_t step, uint8_t number_of_pages, uint8_t *source_page, uint8_t *destination_page)
+{
+	if(step < number_of_pages)
+	{
+		*source_page = BL_SLOT_A_PAGE + (number_of_pages - 1 - step);
+		*destination_page = *source_page + 1;
+	}else
+	{
+		uint8_t page = (step - number_of_pages) / 2;
+
+		if(((step - number_of_pages) % 2) == 0)
+		{
+			*source_page = BL_SLOT_B_PAGE + page;
+			*destination_page = BL_SLOT_A_PAGE + page;
+		}else
+		{
+			*source_page = BL_SLOT_A_PAGE + page + 1;
+			*destination_page = BL_SLOT_B_PAGE + page;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+/*
+ * bl_swap.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_SWAP_H_
+#define BL_SWAP_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+// request at the start of the journal page, one halfword per swap step follows it
+typedef struct {
+	uint32_t magic;             // BL_SWAP_REQUEST_MAGIC
+	uint32_t number_of_pages;   // pages swapped from the start of each slot, at most BL_SWAP_MAX_PAGES
+	uint32_t image_CRC;         // image CRC in the header of the staged image
+	uint32_t request_CRC;       // STM32 CRC-32 of the fields above
+}BL_Swap_Request;
+
+// @brief Steps of a swap of n pages: n moves up in slot A, then two copies per page.
+#define BL_SWAP_STEPS(n)              (3 * (uint16_t)(n))
+
+/*
+* ===============================================
+* APIs Supported by "BL Swap"
+* ===============================================
+*/
+const BL_Swap_Request *BL_Swap_Get_Request(void);
+BL_Status BL_Swap_Set_Request(uint8_t number_of_pages, uint32_t image_CRC);
+BL_Status BL_Swap_Clear_Request(void);
+uint8_t BL_Swap_Step_Done(uint16_t step);
+BL_Status BL_Swap_Set_Step_Done(uint16_t step);
+void BL_Swap_Step_Pages(uint16_t step, uint8_t number_of_pages, uint8_t *source_page, uint8_t *destination_page);
+
+
+#endif /* BL_SWAP_H_ */
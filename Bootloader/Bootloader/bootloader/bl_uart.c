@@ -0,0 +1,647 @@
+/*
+ * bl_uart.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bl_uart.h"
+#include <string.h>
+
+//===============================================
+//Global Variables
+//===============================================
+// circular buffer continuously filled by the USART1 RX DMA channel
+static uint8_t BL_UART_Rx_Ring[BL_UART_RX_RING_SIZE];
+
+// ping-pong buffers drained by the USART1 TX DMA channel
+static uint8_t BL_UART_Tx_Buffer[2][BL_UART_TX_BUFFER_SIZE];
+
+// read position of the receive ring, the write position is the DMA counter
+static uint16_t rx_tail = 0;
+
+// set from BL_UART_IRQHandler when the reception had to be restarted
+static volatile uint8_t rx_restarted = 0;
+
+// transmit buffer to be filled next
+static uint8_t tx_index = 0;
+
+// rate USART1 currently runs at
+static uint32_t current_baud_rate = 0;
+
+
+/*
+* ===============================================
+* Helper functions
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_UART_Rx_Head
+* @brief - Returns the position the RX DMA will write the next byte to.
+* @retval - uint16_t (index in BL_UART_Rx_Ring)
+*/
+static uint16_t BL_UART_Rx_Head(void)
+{
+	uint16_t remaining = (uint16_t)LL_DMA_GetDataLength(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL);
+	return (BL_UART_RX_RING_SIZE - remaining) & (BL_UART_RX_RING_SIZE - 1);
+}
+
+/**================================================================
+* @Fn- BL_UART_Rx_Available
+* @brief - Returns the number of received bytes not consumed yet.
+* @retval - uint16_t (number of bytes)
+*/
+static uint16_t BL_UART_Rx_Available(void)
+{
+	return (BL_UART_Rx_Head() - rx_tail) & (BL_UART_RX_RING_SIZE - 1);
+}
+
+/**================================================================
+* @Fn- BL_UART_Rx_Peek
+* @brief - Reads a received byte without consuming it.
+* @param [in] - uint16_t offset: Offset from the current read position
+* @retval - uint8_t (received byte)
+*/
+static uint8_t BL_UART_Rx_Peek(uint16_t offset)
+{
+	return BL_UART_Rx_Ring[(rx_tail + offset) & (BL_UART_RX_RING_SIZE - 1)];
+}
+
+/**================================================================
+* @Fn- BL_UART_Rx_Read
+* @brief - Copies received bytes out of the ring and consumes them.
+* @param [in] - uint8_t *dest: Destination buffer
+* @param [in] - uint16_t length: Number of bytes to copy (must be available)
+* @retval - None
+*/
+static void BL_UART_Rx_Read(uint8_t *dest, uint16_t length)
+{
+	uint16_t first_part = BL_UART_RX_RING_SIZE - rx_tail;
+
+	if(first_part > length)
+	{
+		first_part = length;
+	}
+
+	memcpy(dest, &BL_UART_Rx_Ring[rx_tail], first_part);
+	memcpy(dest + first_part, BL_UART_Rx_Ring, length - first_part);
+
+	rx_tail = (rx_tail + length) & (BL_UART_RX_RING_SIZE - 1);
+}
+
+/**================================================================
+* @Fn- BL_UART_Rx_Drop
+* @brief - Discards everything received so far.
+* @retval - None
+*/
+static void BL_UART_Rx_Drop(void)
+{
+	rx_tail = BL_UART_Rx_Head();
+}
+
+/**================================================================
+* @Fn- BL_UART_DMA_Reset
+* @brief - Stops a DMA channel of the UART and clears its flags.
+* @param [in] - uint32_t channel: BL_UART_RX_DMA_CHANNEL or BL_UART_TX_DMA_CHANNEL
+* @retval - None
+*/
+static void BL_UART_DMA_Reset(uint32_t channel)
+{
+	LL_DMA_DisableChannel(BL_UART_DMA, channel);
+	LL_DMA_DisableIT_HT(BL_UART_DMA, channel);
+	LL_DMA_DisableIT_TC(BL_UART_DMA, channel);
+	WRITE_REG(BL_UART_DMA->IFCR, DMA_IFCR_CGIF1 << ((channel - LL_DMA_CHANNEL_1) * 4));
+}
+
+/**================================================================
+* @Fn- BL_UART_Start_Receive
+* @brief - Starts the circular DMA reception into BL_UART_Rx_Ring from its start.
+* @param [in] - None
+* @retval - None
+* Note- The HT and TC interrupts of the channel and the IDLE interrupt of the USART only wake the core
+*       from __WFI. The error interrupts restart the reception (see BL_UART_IRQHandler).
+*/
+static void BL_UART_Start_Receive(void)
+{
+	BL_UART_DMA_Reset(BL_UART_RX_DMA_CHANNEL);
+	LL_DMA_ConfigAddresses(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL, LL_USART_DMA_GetRegAddr(BL_UART_INSTANCE),
+	                       (uint32_t)BL_UART_Rx_Ring, LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+	LL_DMA_SetDataLength(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL, BL_UART_RX_RING_SIZE);
+	LL_DMA_EnableIT_HT(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL);
+	LL_DMA_EnableIT_TC(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL);
+	LL_DMA_EnableChannel(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL);
+	rx_tail = 0;
+
+	// reading SR then DR clears a pending IDLE or error flag
+	LL_USART_ClearFlag_IDLE(BL_UART_INSTANCE);
+	LL_USART_EnableIT_IDLE(BL_UART_INSTANCE);
+	LL_USART_EnableIT_PE(BL_UART_INSTANCE);
+	LL_USART_EnableIT_ERROR(BL_UART_INSTANCE);
+	LL_USART_EnableDMAReq_RX(BL_UART_INSTANCE);
+}
+
+/**================================================================
+* @Fn- BL_UART_Stop
+* @brief - Stops the reception and the transmission, USART1 stays enabled.
+* @param [in] - None
+* @retval - None
+* Note- The DMA requests and interrupt enables of USART1 are cleared, both channels are stopped.
+*/
+static void BL_UART_Stop(void)
+{
+	LL_USART_DisableDMAReq_RX(BL_UART_INSTANCE);
+	LL_USART_DisableDMAReq_TX(BL_UART_INSTANCE);
+	LL_USART_DisableIT_IDLE(BL_UART_INSTANCE);
+	LL_USART_DisableIT_PE(BL_UART_INSTANCE);
+	LL_USART_DisableIT_ERROR(BL_UART_INSTANCE);
+
+	BL_UART_DMA_Reset(BL_UART_RX_DMA_CHANNEL);
+	BL_UART_DMA_Reset(BL_UART_TX_DMA_CHANNEL);
+}
+
+/**================================================================
+* @Fn- BL_UART_Start_Transmit
+* @brief - Points the TX DMA channel at a buffer and starts it.
+* @param [in] - const uint8_t *data: Data to be sent
+* @param [in] - uint16_t length: Number of bytes to send
+* @retval - None
+* Note- The previous transmission must be complete (see BL_UART_Flush). No interrupt is used,
+*       BL_UART_Flush polls the channel and the TC flag.
+*/
+static void BL_UART_Start_Transmit(const uint8_t *data, uint16_t length)
+{
+	BL_UART_DMA_Reset(BL_UART_TX_DMA_CHANNEL);
+	LL_DMA_ConfigAddresses(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL, (uint32_t)data,
+	                       LL_USART_DMA_GetRegAddr(BL_UART_INSTANCE), LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+	LL_DMA_SetDataLength(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL, length);
+	LL_USART_ClearFlag_TC(BL_UART_INSTANCE);
+	LL_DMA_EnableChannel(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL);
+	LL_USART_EnableDMAReq_TX(BL_UART_INSTANCE);
+}
+
+/**================================================================
+* @Fn- BL_UART_Baud_Rate_To_BRR
+* @brief - Computes the USART1 BRR value for a baud rate and checks the resulting error.
+* @param [in] - uint32_t baud_rate: Requested baud rate
+* @retval - uint32_t (BRR value, 0 if the rate can not be generated within BL_BAUD_MAX_ERROR)
+* Note- With 16x oversampling BRR holds USARTDIV in 1/16 units, so BRR = PCLK2 / baud rate.
+*/
+static uint32_t BL_UART_Baud_Rate_To_BRR(uint32_t baud_rate)
+{
+	uint32_t brr = 0;
+	uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+
+	if(baud_rate >= BL_MIN_BAUD_RATE && baud_rate <= BL_MAX_BAUD_RATE)
+	{
+		brr = (pclk + baud_rate / 2) / baud_rate;
+
+		if(brr < 16 || brr > 0xFFFF)
+		{
+			brr = 0;
+		}else
+		{
+			uint32_t actual_baud_rate = pclk / brr;
+			uint32_t error = (actual_baud_rate > baud_rate) ? (actual_baud_rate - baud_rate) : (baud_rate - actual_baud_rate);
+
+			// error in 1/1000 of the requested rate
+			if((uint64_t)error * 1000 > (uint64_t)baud_rate * BL_BAUD_MAX_ERROR)
+			{
+				brr = 0;
+			}
+		}
+	}
+
+	return brr;
+}
+
+
+/*
+* ===============================================
+* BL UART APIs Definition
+* ===============================================
+*/
+
+/**================================================================
+* @Fn- BL_UART_Init
+* @brief - Configures USART1 at BL_UART_BAUD_RATE and starts the circular DMA reception with IDLE line detection.
+* @param [in] - None
+* @retval - None
+* Note- BL_Clock_Init must have been called first, the BRR value depends on PCLK2. USART1, its pins,
+*       both DMA channels and their interrupts are driven through the LL layer only, none of them is
+*       part of the CubeMX project. The received bytes land in
+*       BL_UART_Rx_Ring without any CPU work, the HT/TC/IDLE interrupts are only used to wake the core.
+*/
+void BL_UART_Init(void)
+{
+	rx_restarted = 0;
+	tx_index = 0;
+
+	LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_USART1 | LL_APB2_GRP1_PERIPH_GPIOA);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+
+	// PA9 (TX) alternate function push-pull, PA10 (RX) floating input
+	LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_9, LL_GPIO_MODE_ALTERNATE);
+	LL_GPIO_SetPinSpeed(GPIOA, LL_GPIO_PIN_9, LL_GPIO_SPEED_FREQ_HIGH);
+	LL_GPIO_SetPinOutputType(GPIOA, LL_GPIO_PIN_9, LL_GPIO_OUTPUT_PUSHPULL);
+	LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_10, LL_GPIO_MODE_FLOATING);
+
+	// 8N1, 16x oversampling, no flow control
+	LL_USART_Disable(BL_UART_INSTANCE);
+	LL_USART_ConfigCharacter(BL_UART_INSTANCE, LL_USART_DATAWIDTH_8B, LL_USART_PARITY_NONE, LL_USART_STOPBITS_1);
+	LL_USART_SetHWFlowCtrl(BL_UART_INSTANCE, LL_USART_HWCONTROL_NONE);
+	LL_USART_ConfigAsyncMode(BL_UART_INSTANCE);
+	LL_USART_SetTransferDirection(BL_UART_INSTANCE, LL_USART_DIRECTION_TX_RX);
+	WRITE_REG(BL_UART_INSTANCE->BRR, BL_UART_Baud_Rate_To_BRR(BL_UART_BAUD_RATE));
+	current_baud_rate = BL_UART_BAUD_RATE;
+	LL_USART_Enable(BL_UART_INSTANCE);
+
+	BL_UART_Stop();
+	LL_DMA_ConfigTransfer(BL_UART_DMA, BL_UART_RX_DMA_CHANNEL,
+	                      LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR | LL_DMA_PERIPH_NOINCREMENT |
+	                      LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_HIGH);
+	LL_DMA_ConfigTransfer(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL,
+	                      LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_NORMAL | LL_DMA_PERIPH_NOINCREMENT |
+	                      LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_LOW);
+
+	NVIC_SetPriority(USART1_IRQn, 0);
+	NVIC_EnableIRQ(USART1_IRQn);
+	NVIC_SetPriority(DMA1_Channel4_IRQn, 0);
+	NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+	NVIC_SetPriority(DMA1_Channel5_IRQn, 0);
+	NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+	BL_UART_Start_Receive();
+}
+
+/**================================================================
+* @Fn- BL_UART_DeInit
+* @brief - Waits for the pending transmission, stops both DMA channels and releases USART1.
+* @param [in] - None
+* @retval - None
+* Note- Must be called before handing the CPU over to an application, the RX DMA would
+*       otherwise keep writing into RAM the application owns.
+*/
+void BL_UART_DeInit(void)
+{
+	BL_UART_Flush();
+	BL_UART_Stop();
+	NVIC_DisableIRQ(USART1_IRQn);
+	NVIC_DisableIRQ(DMA1_Channel4_IRQn);
+	NVIC_DisableIRQ(DMA1_Channel5_IRQn);
+
+	LL_APB2_GRP1_ForceReset(LL_APB2_GRP1_PERIPH_USART1);
+	LL_APB2_GRP1_ReleaseReset(LL_APB2_GRP1_PERIPH_USART1);
+	LL_APB2_GRP1_DisableClock(LL_APB2_GRP1_PERIPH_USART1);
+
+	// PA9 (TX) back to its reset state, PA10 (RX) already is a floating input
+	LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_9, LL_GPIO_MODE_FLOATING);
+}
+
+/**================================================================
+* @Fn- BL_UART_Handoff
+* @brief - Waits for the pending transmission and stops both DMA channels, USART1 stays enabled.
+* @param [in] - None
+* @retval - None
+* Note- The application can use USART1 at the current rate without initializing it. The DMA
+*       requests and the interrupt enables of USART1 are cleared, both channels are stopped.
+*/
+void BL_UART_Handoff(void)
+{
+	BL_UART_Flush();
+	BL_UART_Stop();
+}
+
+/**================================================================
+* @Fn- BL_UART_Receive_Frame
+* @brief - Waits for a complete frame (2-byte length field followed by length bytes).
+* @param [in] - uint8_t *frame: Buffer the frame is copied to, length field included
+* @param [in] - uint16_t max_length: Size of the frame buffer
+* @param [in] - uint32_t timeout: Time in milliseconds to wait for the first byte of the frame
+* @retval - BL_Status (BL_OK if a complete frame was copied, BL_Error otherwise)
+* Note- The core sleeps between DMA events. A frame that stalls for more than BL_FRAME_TIMEOUT
+*       or does not fit max_length is dropped so the next frame starts on a clean boundary.
+*       The length field is copied as soon as it is received, so after a failure the caller can
+*       still tell which kind of frame was lost. It is left untouched if no byte arrived.
+*/
+BL_Status BL_UART_Receive_Frame(uint8_t *frame, uint16_t max_length, uint32_t timeout)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t start_tick = HAL_GetTick();
+	uint32_t progress_tick = start_tick;
+	uint16_t last_available = 0;
+	uint32_t frame_length = 0;
+
+	while(1)
+	{
+		if(rx_restarted)
+		{
+			rx_restarted = 0;
+			rx_tail = 0;
+			break;
+		}
+
+		uint16_t available = BL_UART_Rx_Available();
+
+		if(frame_length == 0 && available >= 2)
+		{
+			frame[0] = BL_UART_Rx_Peek(0);
+			frame[1] = BL_UART_Rx_Peek(1);
+			frame_length = 2 + ((frame[0] | (frame[1] << 8)) & BL_FRAME_LENGTH_MASK);
+			if(frame_length > max_length)
+			{
+				BL_UART_Rx_Drop();
+				break;
+			}
+		}
+
+		if(frame_length != 0 && available >= frame_length)
+		{
+			BL_UART_Rx_Read(frame, frame_length);
+			bl_status = BL_OK;
+			break;
+		}
+
+		uint32_t current_tick = HAL_GetTick();
+		if(available != last_available)
+		{
+			last_available = available;
+			progress_tick = current_tick;
+		}
+
+		if(available == 0)
+		{
+			if(current_tick - start_tick >= timeout)
+			{
+				break;
+			}
+		}else if(current_tick - progress_tick >= BL_FRAME_TIMEOUT)
+		{
+			BL_UART_Rx_Drop();
+			break;
+		}
+
+		__WFI();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_UART_Receive_Data
+* @brief - Waits for a block of raw bytes outside of the frame format.
+* @param [in] - uint8_t *data: Buffer the bytes are copied to
+* @param [in] - uint16_t length: Number of bytes to receive (less than BL_UART_RX_RING_SIZE)
+* @param [in] - uint32_t timeout: Time in milliseconds the stream may stall before giving up
+* @retval - BL_Status (BL_OK if all bytes were received, BL_Error on timeout or receive error)
+* Note- The timeout restarts whenever new bytes arrive. A receive error loses bytes of the
+*       stream, so it fails the call instead of being skipped like in the frame reception.
+*/
+BL_Status BL_UART_Receive_Data(uint8_t *data, uint16_t length, uint32_t timeout)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t progress_tick = HAL_GetTick();
+	uint16_t last_available = 0;
+
+	while(1)
+	{
+		if(rx_restarted)
+		{
+			rx_restarted = 0;
+			rx_tail = 0;
+			break;
+		}
+
+		uint16_t available = BL_UART_Rx_Available();
+
+		if(available >= length)
+		{
+			BL_UART_Rx_Read(data, length);
+			bl_status = BL_OK;
+			break;
+		}
+
+		uint32_t current_tick = HAL_GetTick();
+		if(available != last_available)
+		{
+			last_available = available;
+			progress_tick = current_tick;
+		}else if(current_tick - progress_tick >= timeout)
+		{
+			break;
+		}
+
+		__WFI();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_UART_Receive_Byte
+* @brief - Waits for a single byte outside of the frame format.
+* @param [in] - uint8_t *byte: Received byte
+* @param [in] - uint32_t timeout: Time in milliseconds to wait for the byte
+* @retval - BL_Status (BL_OK if a byte was received, BL_Error on timeout)
+*/
+BL_Status BL_UART_Receive_Byte(uint8_t *byte, uint32_t timeout)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t start_tick = HAL_GetTick();
+
+	while(1)
+	{
+		if(rx_restarted)
+		{
+			rx_restarted = 0;
+			rx_tail = 0;
+		}
+
+		if(BL_UART_Rx_Available() > 0)
+		{
+			BL_UART_Rx_Read(byte, 1);
+			bl_status = BL_OK;
+			break;
+		}
+
+		if(HAL_GetTick() - start_tick >= timeout)
+		{
+			break;
+		}
+
+		__WFI();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- BL_UART_Transmit
+* @brief - Sends data to the host through the TX DMA channel.
+* @param [in] - const uint8_t *data: Data to be sent
+* @param [in] - uint16_t length: Number of bytes to send
+* @retval - None
+* Note- The data is copied, so the caller may reuse its buffer as soon as the function returns.
+*       The next chunk is copied while the previous one is still on the wire.
+*/
+void BL_UART_Transmit(const uint8_t *data, uint16_t length)
+{
+	while(length > 0)
+	{
+		uint16_t chunk = (length > BL_UART_TX_BUFFER_SIZE) ? BL_UART_TX_BUFFER_SIZE : length;
+
+		memcpy(BL_UART_Tx_Buffer[tx_index], data, chunk);
+
+		BL_UART_Flush();
+		BL_UART_Start_Transmit(BL_UART_Tx_Buffer[tx_index], chunk);
+
+		tx_index ^= 1;
+		data += chunk;
+		length -= chunk;
+	}
+}
+
+/**================================================================
+* @Fn- BL_UART_Transmit_Direct
+* @brief - Sends data to the host by pointing the TX DMA channel straight at it.
+* @param [in] - const uint8_t *data: Data to be sent (flash or SRAM)
+* @param [in] - uint16_t length: Number of bytes to send
+* @retval - None
+* Note- Nothing is copied, so the data must stay unchanged until the next BL_UART_Transmit,
+*       BL_UART_Transmit_Direct or BL_UART_Flush call returns.
+*/
+void BL_UART_Transmit_Direct(const uint8_t *data, uint16_t length)
+{
+	if(length > 0)
+	{
+		BL_UART_Flush();
+		BL_UART_Start_Transmit(data, length);
+	}
+}
+
+/**================================================================
+* @Fn- BL_UART_Flush
+* @brief - Waits until the last byte handed to BL_UART_Transmit has left the shift register.
+* @param [in] - None
+* @retval - None
+* Note- Polls the TX DMA channel until it has handed over its last byte, then the TC flag of USART1.
+*/
+void BL_UART_Flush(void)
+{
+	if(LL_DMA_IsEnabledChannel(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL))
+	{
+		while(LL_DMA_GetDataLength(BL_UART_DMA, BL_UART_TX_DMA_CHANNEL) != 0);
+		while(!LL_USART_IsActiveFlag_TC(BL_UART_INSTANCE));
+
+		LL_USART_DisableDMAReq_TX(BL_UART_INSTANCE);
+		BL_UART_DMA_Reset(BL_UART_TX_DMA_CHANNEL);
+	}
+}
+
+/**================================================================
+* @Fn- BL_UART_Check_Baud_Rate
+* @brief - Checks that a baud rate can be generated from the current PCLK2.
+* @param [in] - uint32_t baud_rate: Requested baud rate
+* @retval - BL_Status (BL_OK if the rate is usable, BL_Error otherwise)
+*/
+BL_Status BL_UART_Check_Baud_Rate(uint32_t baud_rate)
+{
+	return (BL_UART_Baud_Rate_To_BRR(baud_rate) != 0) ? BL_OK : BL_Error;
+}
+
+/**================================================================
+* @Fn- BL_UART_Set_Baud_Rate
+* @brief - Switches USART1 to a new baud rate and restarts the reception.
+* @param [in] - uint32_t baud_rate: New baud rate
+* @retval - BL_Status (BL_OK if the rate was applied, BL_Error if it can not be generated)
+* Note- The pending transmission is completed at the old rate first, anything received
+*       but not consumed yet is discarded.
+*/
+BL_Status BL_UART_Set_Baud_Rate(uint32_t baud_rate)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t brr = BL_UART_Baud_Rate_To_BRR(baud_rate);
+
+	if(brr != 0)
+	{
+		BL_UART_Flush();
+		BL_UART_Stop();
+
+		LL_USART_Disable(BL_UART_INSTANCE);
+		WRITE_REG(BL_UART_INSTANCE->BRR, brr);
+		current_baud_rate = baud_rate;
+		LL_USART_Enable(BL_UART_INSTANCE);
+
+		rx_restarted = 0;
+		BL_UART_Start_Receive();
+
+		bl_status = BL_OK;
+	}
+
+	return bl_status;
+}
+
+
+/**================================================================
+* @Fn- BL_UART_Get_Baud_Rate
+* @brief - Returns the rate USART1 currently runs at.
+* @param [in] - None
+* @retval - uint32_t (baud rate)
+*/
+uint32_t BL_UART_Get_Baud_Rate(void)
+{
+	return current_baud_rate;
+}
+
+
+/**================================================================
+* @Fn- BL_UART_IRQHandler
+* @brief - USART1 interrupt: wakes the core on an idle line and restarts the reception after an error.
+* @param [in] - None
+* @retval - None
+* Note- Called from USART1_IRQHandler. A noise, framing, overrun or parity error loses bytes, so the
+*       ring restarts and the receive functions drop what they were assembling. Reading SR then DR
+*       clears the flags.
+*/
+void BL_UART_IRQHandler(void)
+{
+	uint32_t status = READ_REG(BL_UART_INSTANCE->SR);
+
+	if(status & (USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE))
+	{
+		BL_UART_Start_Receive();
+		rx_restarted = 1;
+	}else if(status & USART_SR_IDLE)
+	{
+		LL_USART_ClearFlag_IDLE(BL_UART_INSTANCE);
+	}
+}
+
+/**================================================================
+* @Fn- DMA1_Channel5_IRQHandler
+* @brief - RX DMA channel interrupt: clears the half and full transfer flags.
+* @param [in] - None
+* @retval - None
+* Note- Replaces the weak handler of the startup file, like the USART1 DMA requests it is not in
+*       the CubeMX project. The interrupt only wakes the core, the receive functions read the
+*       position from the channel counter.
+*/
+void DMA1_Channel5_IRQHandler(void)
+{
+	LL_DMA_ClearFlag_HT5(BL_UART_DMA);
+	LL_DMA_ClearFlag_TC5(BL_UART_DMA);
+	LL_DMA_ClearFlag_TE5(BL_UART_DMA);
+}
+
+/**================================================================
+* @Fn- DMA1_Channel4_IRQHandler
+* @brief - TX DMA channel interrupt: clears the flags of the channel.
+* @param [in] - None
+* @retval - None
+* Note- Replaces the weak handler of the startup file, see DMA1_Channel5_IRQHandler. No interrupt of the channel is enabled, the
+*       transmission is polled by BL_UART_Flush.
+*/
+void DMA1_Channel4_IRQHandler(void)
+{
+	LL_DMA_ClearFlag_GI4(BL_UART_DMA);
+}
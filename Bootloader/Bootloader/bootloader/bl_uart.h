@@ -0,0 +1,37 @@
+/*
+ * bl_uart.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BL_UART_H_
+#define BL_UART_H_
+
+//-----------------------------
+//Includes
+//-----------------------------
+#include "bootloader.h"
+
+
+/*
+* ===============================================
+* APIs Supported by "BL UART"
+* ===============================================
+*/
+void BL_UART_Init(void);
+void BL_UART_DeInit(void);
+void BL_UART_Handoff(void);
+BL_Status BL_UART_Receive_Frame(uint8_t *frame, uint16_t max_length, uint32_t timeout);
+BL_Status BL_UART_Receive_Data(uint8_t *data, uint16_t length, uint32_t timeout);
+BL_Status BL_UART_Receive_Byte(uint8_t *byte, uint32_t timeout);
+void BL_UART_Transmit(const uint8_t *data, uint16_t length);
+void BL_UART_Transmit_Direct(const uint8_t *data, uint16_t length);
+void BL_UART_Flush(void);
+BL_Status BL_UART_Check_Baud_Rate(uint32_t baud_rate);
+BL_Status BL_UART_Set_Baud_Rate(uint32_t baud_rate);
+uint32_t BL_UART_Get_Baud_Rate(void);
+void BL_UART_IRQHandler(void);
+
+
+#endif /* BL_UART_H_ */
@@ -6,11 +6,48 @@
  */
 
 #include "bootloader.h"
+#include "bl_uart.h"
+#include "bl_clock.h"
+#include "bl_crc.h"
+#include "bl_flash.h"
+#include "bl_image.h"
+#include "bl_slot.h"
+#include "bl_swap.h"
+#include "bl_handoff.h"
 
 //===============================================
 //Global Variables
 //===============================================
-static uint8_t BL_Buffer[BL_BUFFER_LENGTH];
+// word aligned so the CRC DMA can read the frame as words
+static uint8_t BL_Buffer[BL_BUFFER_LENGTH] __attribute__((aligned(4)));
+
+// page queued by BL_MEM_WRITE_CMD, flashed while the next frame is streaming into the UART DMA ring
+static uint8_t BL_Page_Buffer[PAGE_SIZE] __attribute__((aligned(4)));
+static uint8_t pending_page_valid = 0;
+static uint8_t pending_page_number = 0;
+static uint16_t pending_page_length = 0;
+
+// first queued page that failed to program since the last write report
+static uint8_t failed_page_number = BL_NO_FAILED_PAGE;
+
+// last decompressed bytes of a compressed write, the matches copy from here
+static uint8_t BL_LZ_Window[BL_LZ_WINDOW_SIZE];
+
+// update session opened by BL_BEGIN_SESSION_CMD, its pages are erased ahead of the writes
+static uint8_t session_active = 0;
+static uint8_t session_start_page = 0;
+static uint32_t session_image_length = 0;
+static uint32_t session_image_CRC = 0;
+// first page that failed to program during the session
+static uint8_t session_failed_page = BL_NO_FAILED_PAGE;
+
+// linker script symbols: the flash image ends with the initial values of .data, the SRAM after the
+// heap reserved from _end is free down to the stack
+extern uint32_t _sidata, _sdata, _edata, _end, _Min_Heap_Size;
+
+// set while answering a windowed frame, the responses then echo its sequence number
+static uint8_t window_frame = 0;
+static uint8_t window_sequence = 0;
 
 uint8_t BL_Commands[] = {
 		BL_GET_VER_CMD,
@@ -23,6 +60,21 @@ uint8_t BL_Commands[] = {
 		BL_MEM_READ_CMD,
 		BL_JUMP_TO_MAIN,
 		BL_CHANGE_RDP_Level_CMD,
+		BL_SET_BAUD_CMD,
+		BL_MEM_WRITE_BULK_CMD,
+		BL_GET_CRC_CMD,
+		BL_MEM_READ_STREAM_CMD,
+		BL_MEM_WRITE_COMPRESSED_CMD,
+		BL_FILL_PAGES_CMD,
+		BL_BEGIN_SESSION_CMD,
+		BL_END_SESSION_CMD,
+		BL_MASS_ERASE_CMD,
+		BL_GET_IMAGE_HEADER_CMD,
+		BL_GET_SLOT_CMD,
+		BL_SET_SLOT_CMD,
+		BL_SWAP_CMD,
+		BL_RAM_WRITE_CMD,
+		BL_RAM_EXEC_CMD,
 };
 
 #if (BUILD_TYPE == BUILD_TYPE_DEBUG)
@@ -37,6 +89,29 @@ uint8_t BL_Commands[] = {
 //===============================================
 typedef void (*PFunc)();
 
+// update parameters the application left in the backup registers with BL_UPDATE_REQUEST_MAGIC
+typedef struct {
+	uint8_t requested;
+	uint32_t baud_rate;         // 0 keeps the default rate
+	uint16_t slot;              // BL_SLOT_A, BL_SLOT_B or BL_UPDATE_NO_SLOT
+	uint32_t image_length;      // bytes written from the first page of the slot
+}BL_Update_Request;
+
+// state of a compressed write
+typedef struct {
+	uint32_t input_remaining;   // compressed bytes still in the receive ring or on the line
+	uint16_t block_length;      // compressed bytes of the block in BL_Buffer
+	uint16_t block_index;       // next byte to decode in BL_Buffer
+	uint32_t image_length;
+	uint32_t output_length;     // bytes decompressed so far
+	uint32_t image_CRC;
+	uint8_t start_page;
+	uint8_t write_status;       // FLASH_WRITE_SUCCESS or FLASH_WRITE_ERROR
+	uint8_t failed_page;
+	uint8_t corrupted;          // the stream does not decode into the announced image
+	uint8_t stalled;            // the stream stopped, the rest of it is lost
+}BL_LZ_Stream;
+
 
 
 /*
@@ -53,13 +128,41 @@ static void Bootloader_Get_Read_Protection_Status(uint8_t *data);
 static BL_Status Bootloader_Go_TO_Address(uint8_t *data);
 static BL_Status Bootloader_Erase_Flash(uint8_t *data);
 static BL_Status Bootloader_Write_Memory(uint8_t *data);
+static BL_Status Bootloader_Write_Memory_Bulk(uint8_t *data);
+static BL_Status Bootloader_Write_Memory_Compressed(uint8_t *data);
+static BL_Status Bootloader_Fill_Pages(uint8_t *data);
+static BL_Status Bootloader_Begin_Session(uint8_t *data);
+static BL_Status Bootloader_End_Session(uint8_t *data);
+static BL_Status Bootloader_Mass_Erase(uint8_t *data);
+static BL_Status Bootloader_Get_Image_Header(uint8_t *data);
+static void Bootloader_Get_Slot(uint8_t *data);
+static BL_Status Bootloader_Set_Slot(uint8_t *data);
+static void Bootloader_Invalidate_Images(uint8_t start_page, uint8_t number_of_pages);
+static BL_Status Bootloader_Swap(uint8_t *data);
+static BL_Status Bootloader_Swap_Images(void);
+static BL_Status Bootloader_Write_RAM(uint8_t *data);
+static BL_Status Bootloader_Execute_RAM(uint8_t *data);
+static uint8_t isValidRAMImageRange(uint32_t address, uint32_t length);
+static uint8_t isValidPageRange(uint8_t start_page, uint32_t length);
 static BL_Status Bootloader_Read_Memory(uint8_t *data);
+static BL_Status Bootloader_Read_Memory_Stream(uint8_t *data);
+static BL_Status Bootloader_Get_CRC(uint8_t *data);
 static BL_Status Bootloader_Set_Read_Protection_Level(uint8_t *data);
+static BL_Status Bootloader_Set_Baud_Rate(uint8_t *data);
 static void Jump_To_App_Main(uint8_t *data);
+static void Bootloader_Jump_To_Application(uint32_t address, uint8_t boot_reason, uint8_t slot, uint32_t image_CRC);
+static uint8_t Bootloader_Application_Valid(uint32_t address);
+static uint8_t Bootloader_Boot_Requested(BL_Update_Request *update);
+static void Bootloader_Prepare_Update(const BL_Update_Request *update);
+static BL_Status Bootloader_Sync(uint32_t timeout);
+static void Bootloader_Commit_Pending_Write(void);
+static uint8_t Flash_Memory_Write_Page(uint8_t page_number, uint16_t payload_length, uint8_t *payload);
 
 static void Bootloader_Send_Ack();
 static void Bootloader_Send_NAck();
 static uint8_t Bootloader_CRC_Verification(uint8_t *pData, uint16_t data_length, uint32_t host_CRC);
+static uint16_t Bootloader_Get_Uint16(const uint8_t *data);
+static uint32_t Bootloader_Get_Uint32(const uint8_t *data);
 
 
 /*
@@ -82,77 +185,237 @@ static uint8_t Bootloader_CRC_Verification(uint8_t *pData, uint16_t data_length,
 * ===============================================
 */
 
+/**================================================================
+* @Fn- Bootloader_Autoboot
+* @brief - Starts the application at reset unless the bootloader is asked to stay.
+* @param [in] - None
+* @param [out] - None
+* @retval - None
+* Note- Called once after BL_UART_Init. The bootloader stays when the boot pin is active, when the
+*       application left BL_BOOT_REQUEST_MAGIC in the backup register before its reset, or when the
+*       host sends BL_BAUD_SYNC_BYTE within BL_AUTOBOOT_WINDOW. Otherwise the application of the
+*       active slot is started if its image header and CRC check out (see BL_Image_Check, the result
+*       is cached in the header) and its vector table is sane, so a device with a valid application
+*       boots within milliseconds. A broken active slot falls back to the other one.
+*       A swap requested before the reset, or cut by one, is completed first in any case.
+*       An update requested by the application with BL_UPDATE_REQUEST_MAGIC keeps the bootloader
+*       without sync window and is prepared right away (see Bootloader_Prepare_Update).
+*       With BL_STAGE0_ENABLE a marked valid active image is already started by stage 0 at reset,
+*       this only runs when stage 0 handed over (see BL_Stage0_Reset_Handler).
+*       Returns when the bootloader has to serve the host.
+*/
+void Bootloader_Autoboot(void)
+{
+	BL_Update_Request update = {0};
+	uint8_t stay = Bootloader_Boot_Requested(&update);
+
+	// a failed swap leaves its journal, the slots are checked as usual and it is retried next reset
+	Bootloader_Swap_Images();
+
+	if(update.requested)
+	{
+		Bootloader_Prepare_Update(&update);
+	}
+
+#if (BL_AUTOBOOT_ENABLE == 1)
+#if (BL_BOOT_PIN_ENABLE == 1)
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	BL_BOOT_PIN_CLK_ENABLE();
+	GPIO_InitStruct.Pin = BL_BOOT_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(BL_BOOT_PIN_PORT, &GPIO_InitStruct);
+
+	if(HAL_GPIO_ReadPin(BL_BOOT_PIN_PORT, BL_BOOT_PIN) == BL_BOOT_PIN_ACTIVE)
+	{
+		stay = 1;
+	}
+	HAL_GPIO_DeInit(BL_BOOT_PIN_PORT, BL_BOOT_PIN);
+#endif
+
+	if(!stay && Bootloader_Sync(BL_AUTOBOOT_WINDOW) != BL_OK)
+	{
+		uint8_t active_slot = BL_Slot_Get_Active();
+
+		for(uint8_t i = 0; i < BL_NUMBER_OF_SLOTS; i++)
+		{
+			uint8_t slot = (active_slot + i) % BL_NUMBER_OF_SLOTS;
+			uint32_t header_address = BL_Slot_Header_Address(slot);
+			uint32_t address = header_address + BL_IMAGE_HEADER_SIZE;
+
+			if(BL_Image_Check(header_address, 1) == BL_OK && Bootloader_Application_Valid(address))
+			{
+				Bootloader_Jump_To_Application(address, (i == 0) ? BL_BOOT_REASON_AUTOBOOT : BL_BOOT_REASON_FALLBACK,
+											   slot, ((const BL_Image_Header *)header_address)->image_CRC);
+			}
+		}
+	}
+#else
+	// without autoboot the bootloader always waits for the host
+	(void)stay;
+#endif
+}
+
 /**================================================================
 * @Fn- Bootloader_Get_Command
 * @brief - Handles receiving and processing bootloader commands from the host.
 * @param [in] - None
 * @param [out] - None
 * @retval - BL_Status (Bootloader operation status: BL_OK or BL_Error)
-* Note- It receives the command and data from UART, parses the command, and executes the corresponding bootloader action.
+* Note- The frame is collected by the UART DMA engine, this function only wakes up once it is complete,
+*       then parses the command and executes the corresponding bootloader action.
+*       A legacy frame is [length][command][arguments][CRC] and is answered with [ACK/NACK][data].
+*       A windowed frame has BL_WINDOW_FRAME_FLAG set in its length and a sequence number before the
+*       command: [length][sequence][command][arguments][CRC], its CRC covers the whole frame and it is
+*       answered with [ACK/NACK][sequence][data]. Frames are processed and answered in order, so the host
+*       can keep BL_WINDOW_SIZE of them in flight and resend only the ones NACKed or left unanswered.
 */
 BL_Status Bootloader_Get_Command()
 {
 	memset(BL_Buffer, 0, BL_BUFFER_LENGTH);
 	BL_Status bl_status = BL_Error;
-    HAL_StatusTypeDef HAL_Status = HAL_ERROR;
+	BL_Status rx_status = BL_Error;
     uint8_t CRC_ver_status = CRC_VERIFICATION_FAILED;
 
-	HAL_Status = HAL_UART_Receive(BL_UART, BL_Buffer, 2, BL_MAX_TIMEOUT);
-	if(HAL_Status == HAL_OK)
+	// flash the page queued by the previous command while the DMA receives the next frame
+	Bootloader_Commit_Pending_Write();
+
+	rx_status = BL_UART_Receive_Frame(BL_Buffer, BL_BUFFER_LENGTH, BL_MAX_TIMEOUT);
+
+	// the frame type comes from this frame's length field, also when only the field was received
+	uint16_t length_field = Bootloader_Get_Uint16(BL_Buffer);
+	window_frame = (length_field & BL_WINDOW_FRAME_FLAG) ? 1 : 0;
+
+	if(rx_status == BL_OK)
 	{
-		uint16_t data_length = *((uint16_t*)BL_Buffer);
-		HAL_Status = HAL_UART_Receive(BL_UART, BL_Buffer + 2, data_length, BL_MAX_TIMEOUT);
+		uint16_t data_length = length_field & BL_FRAME_LENGTH_MASK;
+		uint8_t *command = BL_Buffer;
+
+		if(window_frame)
+		{
+			window_sequence = BL_Buffer[2];
 
-		uint32_t host_CRC = *((uint32_t *)(BL_Buffer + 2 + (data_length - 4)));
-		CRC_ver_status = Bootloader_CRC_Verification(BL_Buffer, 3, host_CRC);
+			// skip the sequence number, the handlers expect the command at [2] and its arguments from [3]
+			command = BL_Buffer + 1;
+		}
+
+		// the CRC covers the whole frame up to the CRC itself, including the length field
+		if(data_length >= (window_frame ? 6 : 5))
+		{
+			uint32_t host_CRC = Bootloader_Get_Uint32(BL_Buffer + 2 + (data_length - 4));
+			CRC_ver_status = Bootloader_CRC_Verification(BL_Buffer, 2 + (data_length - 4), host_CRC);
+		}
 
-		if(HAL_Status == HAL_OK && CRC_ver_status == CRC_VERIFICATION_SUCCESS)
+		if(CRC_ver_status == CRC_VERIFICATION_SUCCESS)
 		{
-			switch(BL_Buffer[2])
+			switch(command[2])
 			{
 				case BL_GET_VER_CMD:
-					Bootloader_Get_Version(BL_Buffer);
+					Bootloader_Get_Version(command);
 					bl_status = BL_OK;
 					break;
 
 				case BL_GET_HELP_CMD:
-					Bootloader_Get_Help(BL_Buffer);
+					Bootloader_Get_Help(command);
 					bl_status = BL_OK;
 					break;
 
 				case BL_GET_CID_CMD:
-					Bootloader_Get_Chip_ID(BL_Buffer);
+					Bootloader_Get_Chip_ID(command);
 					bl_status = BL_OK;
 					break;
 
 				case BL_GET_RDP_STATUS_CMD:
-					Bootloader_Get_Read_Protection_Status(BL_Buffer);
+					Bootloader_Get_Read_Protection_Status(command);
 					bl_status = BL_OK;
 					break;
 
 				case BL_GO_TO_ADDR_CMD:
-					bl_status = Bootloader_Go_TO_Address(BL_Buffer);
+					bl_status = Bootloader_Go_TO_Address(command);
 					break;
 
 				case BL_FLASH_ERASE_CMD:
-					bl_status = Bootloader_Erase_Flash(BL_Buffer);
+					bl_status = Bootloader_Erase_Flash(command);
 					break;
 
 				case BL_MEM_WRITE_CMD:
-					bl_status = Bootloader_Write_Memory(BL_Buffer);
+					bl_status = Bootloader_Write_Memory(command);
 					break;
 
 				case BL_MEM_READ_CMD:
-					bl_status = Bootloader_Read_Memory(BL_Buffer);
+					bl_status = Bootloader_Read_Memory(command);
 					break;
 
 				case BL_JUMP_TO_MAIN:
-					Jump_To_App_Main(BL_Buffer);
+					Jump_To_App_Main(command);
 					break;
 
 				case BL_CHANGE_RDP_Level_CMD:
-					bl_status = Bootloader_Set_Read_Protection_Level(BL_Buffer);
+					bl_status = Bootloader_Set_Read_Protection_Level(command);
+					break;
+
+				case BL_SET_BAUD_CMD:
+					bl_status = Bootloader_Set_Baud_Rate(command);
+					break;
+
+				case BL_MEM_WRITE_BULK_CMD:
+					bl_status = Bootloader_Write_Memory_Bulk(command);
+					break;
+
+				case BL_GET_CRC_CMD:
+					bl_status = Bootloader_Get_CRC(command);
+					break;
+
+				case BL_MEM_READ_STREAM_CMD:
+					bl_status = Bootloader_Read_Memory_Stream(command);
+					break;
+
+				case BL_MEM_WRITE_COMPRESSED_CMD:
+					bl_status = Bootloader_Write_Memory_Compressed(command);
+					break;
+
+				case BL_FILL_PAGES_CMD:
+					bl_status = Bootloader_Fill_Pages(command);
+					break;
+
+				case BL_BEGIN_SESSION_CMD:
+					bl_status = Bootloader_Begin_Session(command);
+					break;
+
+				case BL_END_SESSION_CMD:
+					bl_status = Bootloader_End_Session(command);
+					break;
+
+				case BL_MASS_ERASE_CMD:
+					bl_status = Bootloader_Mass_Erase(command);
+					break;
+
+				case BL_GET_IMAGE_HEADER_CMD:
+					bl_status = Bootloader_Get_Image_Header(command);
 					break;
+
+				case BL_GET_SLOT_CMD:
+					Bootloader_Get_Slot(command);
+					bl_status = BL_OK;
+					break;
+
+				case BL_SET_SLOT_CMD:
+					bl_status = Bootloader_Set_Slot(command);
+					break;
+
+				case BL_SWAP_CMD:
+					bl_status = Bootloader_Swap(command);
+					break;
+
+				case BL_RAM_WRITE_CMD:
+					bl_status = Bootloader_Write_RAM(command);
+					break;
+
+				case BL_RAM_EXEC_CMD:
+					bl_status = Bootloader_Execute_RAM(command);
+					break;
+
 				default:
 					break;
 			}
@@ -164,9 +427,14 @@ BL_Status Bootloader_Get_Command()
 		}
 	}else {
 		#if (BUILD_TYPE == BUILD_TYPE_DEBUG)
-			Bootloader_Write_Message("bl could not receive the command length");
+			Bootloader_Write_Message("bl could not receive the command frame");
 		#endif
-		Bootloader_Send_NAck();
+		// a windowed host recovers from a lost frame with its own timeout, a NACK without
+		// sequence number would only break its response parsing. Nothing received counts as legacy.
+		if(!window_frame)
+		{
+			Bootloader_Send_NAck();
+		}
 	}
 
 	return bl_status;
@@ -191,7 +459,7 @@ void Bootloader_Write_Message(char *format,...)
    int len = vsnprintf(message, sizeof(message), format, args);
    message[len++] = '\n';
 
-   HAL_UART_Transmit(BL_UART, message, len, BL_MAX_TIMEOUT);
+   BL_UART_Transmit(message, len);
 
    va_end(args);
 }
@@ -208,9 +476,9 @@ void Bootloader_Write_Message(char *format,...)
 */
 static void Bootloader_Send_Data_To_Host(uint8_t *data, uint8_t length)
 {
-	HAL_UART_Transmit(BL_UART, &length, 1, BL_MAX_TIMEOUT);
+	BL_UART_Transmit(&length, 1);
 	if(data != NULL)
-		HAL_UART_Transmit(BL_UART, data, length, BL_MAX_TIMEOUT);
+		BL_UART_Transmit(data, length);
 }
 
 /**================================================================
@@ -220,11 +488,12 @@ static void Bootloader_Send_Data_To_Host(uint8_t *data, uint8_t length)
 * @param [out] - None
 * @retval - None
 * Note- The ACK signal indicates that the bootloader has successfully received and processed a command.
+*       For a windowed frame the sequence number follows the ACK.
 */
 static void Bootloader_Send_Ack()
 {
-	uint8_t ack = BL_ACK;
-	HAL_UART_Transmit(BL_UART, &ack, 1, 100000);
+	uint8_t ack[2] = {BL_ACK, window_sequence};
+	BL_UART_Transmit(ack, window_frame ? 2 : 1);
 }
 
 /**================================================================
@@ -234,11 +503,12 @@ static void Bootloader_Send_Ack()
 * @param [out] - None
 * @retval - None
 * Note- The NACK signal indicates that the bootloader failed to process the received command.
+*       For a windowed frame the sequence number follows the NACK.
 */
 static void Bootloader_Send_NAck()
 {
-	uint8_t nack = BL_NACK;
-	HAL_UART_Transmit(BL_UART, &nack, 1, 100000);
+	uint8_t nack[2] = {BL_NACK, window_sequence};
+	BL_UART_Transmit(nack, window_frame ? 2 : 1);
 }
 
 /**================================================================
@@ -263,17 +533,90 @@ static uint8_t isValidAddress(uint32_t address)
 	return isValid;
 }
 
+/**================================================================
+* @Fn- isValidRange
+* @brief - Checks if a memory range lies completely within the flash or the SRAM.
+* @param [in] - uint32_t address: First address of the range
+* @param [in] - uint32_t length: Number of bytes in the range
+* @param [out] - uint8_t: Returns 1 if the range is valid, 0 otherwise
+* @retval - uint8_t (1 for valid, 0 for invalid)
+*/
+static uint8_t isValidRange(uint32_t address, uint32_t length)
+{
+	uint8_t isValid = 0;
+	if(address >= FLASH_BASE && length <= FLASH_SIZE && address - FLASH_BASE <= FLASH_SIZE - length)
+	{
+		isValid = 1;
+	}else if(address >= SRAM_BASE && length <= SRAM_SIZE && address - SRAM_BASE <= SRAM_SIZE - length)
+	{
+		isValid = 1;
+	}
+
+	return isValid;
+}
+
+/**================================================================
+* @Fn- isValidPageRange
+* @brief - Checks if an image of a given length starting at a page fits in the pages open to the host.
+* @param [in] - uint8_t start_page: First page of the image
+* @param [in] - uint32_t length: Number of bytes in the image
+* @param [out] - uint8_t: Returns 1 if the image fits, 0 otherwise
+* @retval - uint8_t (1 for valid, 0 for invalid)
+* Note- Pages below BL_SLOT_A_PAGE hold stage 0, the service table and the bootloader, the pages
+*       from BL_HOST_PAGE_END on the swap journal and the slot metadata: no host command may write
+*       or erase them. The length is bounded before it is rounded up to pages, a length close to
+*       4 GB would otherwise wrap to zero pages.
+*/
+static uint8_t isValidPageRange(uint8_t start_page, uint32_t length)
+{
+	uint8_t isValid = 0;
+	if(length > 0 && start_page >= BL_SLOT_A_PAGE && start_page < BL_HOST_PAGE_END &&
+	   length <= (uint32_t)(BL_HOST_PAGE_END - start_page) * PAGE_SIZE)
+	{
+		isValid = 1;
+	}
+
+	return isValid;
+}
+
+/**================================================================
+* @Fn- isValidRAMImageRange
+* @brief - Checks if a memory range lies in the SRAM image window and off the live bootloader RAM.
+* @param [in] - uint32_t address: First address of the range
+* @param [in] - uint32_t length: Number of bytes in the range
+* @param [out] - uint8_t: Returns 1 if the range is valid, 0 otherwise
+* @retval - uint8_t (1 for valid, 0 for invalid)
+* Note- The window is fixed so images can be linked for it, the range must also be above the heap and
+*       below the stack in use, in case the bootloader variables grew into the window.
+*/
+static uint8_t isValidRAMImageRange(uint32_t address, uint32_t length)
+{
+	uint8_t isValid = 0;
+	uint32_t free_start = (uint32_t)&_end + (uint32_t)&_Min_Heap_Size;
+	uint32_t free_end = __get_MSP() - BL_MASS_ERASE_STACK_MARGIN;
+
+	if(address >= BL_RAM_IMAGE_ADDRESS && length <= BL_RAM_IMAGE_SIZE &&
+	   address - BL_RAM_IMAGE_ADDRESS <= BL_RAM_IMAGE_SIZE - length &&
+	   address >= free_start && address + length <= free_end)
+	{
+		isValid = 1;
+	}
+
+	return isValid;
+}
+
 /**================================================================
 * @Fn- Bootloader_Get_Version
 * @brief - Retrieves the bootloader version and sends it to the host.
 * @param [in] - uint8_t *data: Received data buffer (not used in this function)
 * @param [out] - None
 * @retval - None
-* Note- Sends an array containing the vendor ID, major, minor, and patch version to the host.
+* Note- Sends an array containing the vendor ID, major, minor, and patch version to the host,
+*       followed by the number of windowed frames the host may keep in flight.
 */
 static void Bootloader_Get_Version(uint8_t *data)
 {
-	uint8_t bl_version[] = {BL_VENDOR_ID, BL_SW_MAJOR_VERSION, BL_SW_MINOR_VERSION, BL_SW_PATCH_VERSION};
+	uint8_t bl_version[] = {BL_VENDOR_ID, BL_SW_MAJOR_VERSION, BL_SW_MINOR_VERSION, BL_SW_PATCH_VERSION, BL_WINDOW_SIZE};
 	Bootloader_Send_Ack();
 	Bootloader_Send_Data_To_Host(bl_version, sizeof(bl_version));
 }
@@ -331,219 +674,1311 @@ static void Bootloader_Get_Read_Protection_Status(uint8_t *data)
 }
 
 /**================================================================
-* @Fn- Bootloader_Go_TO_Address
-* @brief - Jumps to a specified memory address to execute code.
-* @param [in] - uint8_t *data: Command data containing the target address
-* @param [out] - BL_Status: BL_OK if address is valid, BL_Error otherwise
+* @Fn- Bootloader_Get_Image_Header
+* @brief - Sends the image header of an application slot to the host.
+* @param [in] - uint8_t *data: Command data containing the slot
+* @param [out] - BL_Status: BL_OK if the slot exists, BL_Error otherwise
 * @retval - BL_Status (Bootloader operation status)
-* Note- Verifies if the address is valid before jumping, sends ACK or NACK accordingly.
+* Note- The response is [valid][header as stored in flash]: valid is 1 when the header and the image
+*       pass BL_Image_Check, which computes the image CRC unless the header is marked valid. The
+*       header is sent as is, so the host can read the installed version even of a broken image.
 */
-static BL_Status Bootloader_Go_TO_Address(uint8_t *data)
+static BL_Status Bootloader_Get_Image_Header(uint8_t *data)
 {
 	BL_Status bl_status = BL_Error;
-	uint32_t address = *((uint32_t *)(data + 3));
-
-	uint8_t validAddress = isValidAddress(address);
+	uint8_t slot = data[3];
 
-	if(validAddress)
+	if(slot < BL_NUMBER_OF_SLOTS)
 	{
-		Bootloader_Send_Ack();
-		Bootloader_Send_Data_To_Host(NULL, 0);
+		uint32_t header_address = BL_Slot_Header_Address(slot);
+		uint8_t image_report[1 + sizeof(BL_Image_Header)];
 
-		PFunc function = (void *)(address+1);
+		image_report[0] = (BL_Image_Check(header_address, 0) == BL_OK) ? 1 : 0;
+		memcpy(image_report + 1, (const uint8_t *)header_address, sizeof(BL_Image_Header));
 
-		function();
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(image_report, sizeof(image_report));
+		bl_status = BL_OK;
 	}else
 	{
-	    Bootloader_Send_NAck();
+		Bootloader_Send_NAck();
 	}
+
 	return bl_status;
 }
 
-
 /**================================================================
-* @Fn- Flash_Memory_Erase_Pages
-* @brief - Erases a specified number of flash pages starting from a given page number.
-* @param [in] - uint8_t start_page: Starting page number for erasing
-* @param [in] - uint8_t number_of_pages: Number of pages to erase
-* @param [out] - uint8_t: Erase status (PAGE_ERASE_SUCCESS or PAGE_ERASE_ERROR)
-* @retval - uint8_t (Erase status)
-* Note- Unlocks flash, erases the specified pages, and locks flash again.
+* @Fn- Bootloader_Get_Slot
+* @brief - Sends the active application slot and the slot layout to the host.
+* @param [in] - uint8_t *data: Received data buffer (not used in this function)
+* @param [out] - None
+* @retval - None
+* Note- The response is [active slot][first page of slot A][first page of slot B][pages per slot],
+*       so the host writes an update to the inactive slot without knowing the build configuration.
 */
-static uint8_t Flash_Memory_Erase_Pages(uint8_t start_page, uint8_t number_of_pages)
+static void Bootloader_Get_Slot(uint8_t *data)
 {
-	uint8_t erase_status = PAGE_ERASE_SUCCESS;
-	HAL_StatusTypeDef HAL_Status = HAL_ERROR;
-
-	if(start_page < NUM_OF_PAGES - 1)
-	{
-		if(start_page + number_of_pages > NUM_OF_PAGES)
-		{
-			number_of_pages = NUM_OF_PAGES - start_page;
-		}
-
-		HAL_Status = HAL_FLASH_Unlock();
-		if(HAL_Status == HAL_OK)
-		{
-			FLASH_EraseInitTypeDef pEraseInit;
-			pEraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
-			pEraseInit.Banks = FLASH_BANK_1;
-			pEraseInit.PageAddress = FLASH_BASE + start_page * PAGESIZE;
-			pEraseInit.NbPages = number_of_pages;
+	uint8_t slot_report[2 + BL_NUMBER_OF_SLOTS];
 
-			uint32_t PageError;
-			HAL_Status = HAL_FLASHEx_Erase(&pEraseInit, &PageError);
-
-			if(HAL_Status == HAL_OK && PageError == 0xFFFFFFFF)
-			{
-				HAL_Status = HAL_FLASH_Lock();
-				while(HAL_Status == HAL_ERROR)
-				{
-					HAL_Status = HAL_FLASH_Lock();
-					erase_status = PAGE_ERASE_ERROR;
-				}
-			}else
-			{
-				erase_status = PAGE_ERASE_ERROR;
-			}
-		}else
-		{
-			erase_status = PAGE_ERASE_ERROR;
-		}
-	}else
+	slot_report[0] = BL_Slot_Get_Active();
+	for(uint8_t slot = 0; slot < BL_NUMBER_OF_SLOTS; slot++)
 	{
-		erase_status = PAGE_ERASE_ERROR;
+		slot_report[1 + slot] = BL_Slot_First_Page(slot);
 	}
+	slot_report[1 + BL_NUMBER_OF_SLOTS] = BL_SLOT_PAGES;
 
-	return erase_status;
+	Bootloader_Send_Ack();
+	Bootloader_Send_Data_To_Host(slot_report, sizeof(slot_report));
 }
 
 /**================================================================
-* @Fn- Bootloader_Erase_Flash
-* @brief - Erases specified flash memory pages as requested by the host.
-* @param [in] - uint8_t *data: Command data containing start page and number of pages
-* @param [out] - BL_Status: BL_OK if successful, BL_Error otherwise
+* @Fn- Bootloader_Set_Slot
+* @brief - Makes an application slot the one started at reset.
+* @param [in] - uint8_t *data: Command data containing the slot
+* @param [out] - BL_Status: BL_OK if the slot was selected, BL_Error otherwise
 * @retval - BL_Status (Bootloader operation status)
-* Note- Sends an ACK or NACK depending on the success of the erase operation.
+* Note- Only a slot holding a valid image can be selected. The switch is one record programmed into
+*       the metadata pages (see BL_Slot_Set_Active), the images are not moved.
 */
-static BL_Status Bootloader_Erase_Flash(uint8_t *data)
+static BL_Status Bootloader_Set_Slot(uint8_t *data)
 {
-		BL_Status bl_status = BL_Error;
-		uint8_t start_page = data[3];
-		uint8_t number_of_pages = data[4];
-
-		uint8_t erase_status = Flash_Memory_Erase_Pages(start_page, number_of_pages);
+	BL_Status bl_status = BL_Error;
+	uint8_t slot = data[3];
 
-		if(erase_status == PAGE_ERASE_SUCCESS)
+	if(slot < BL_NUMBER_OF_SLOTS && BL_Image_Check(BL_Slot_Header_Address(slot), 1) == BL_OK)
+	{
+		// the metadata pages are outside the slots, the erase-ahead range is left as it is
+		BL_Flash_Erase_Ahead_Pause(BL_SLOT_META_PAGE);
+		if(BL_Slot_Get_Active() == slot || BL_Slot_Set_Active(slot) == BL_OK)
 		{
 			bl_status = BL_OK;
 		}
+		BL_Flash_Erase_Ahead_Resume();
+	}
 
-		if(bl_status == BL_OK)
-		{
-			Bootloader_Send_Ack();
-			Bootloader_Send_Data_To_Host(NULL, 0);
-		}else
-		{
-			Bootloader_Send_NAck();
-		}
-
-		return bl_status;
-}
-
-/**================================================================
-* @Fn- Flash_Memory_Write_Page
-* @brief - Writes data to a specified flash page.
-* @param [in] - uint8_t page_number: The flash page number to write to
-* @param [in] - uint16_t payload_length: The length of the data to write
-* @param [in] - uint8_t *payload: The data to be written to flash
-* @param [out] - uint8_t: Write status (FLASH_WRITE_SUCCESS or FLASH_WRITE_ERROR)
-* @retval - uint8_t (Write status)
-* Note- Unlocks flash, writes the data to the specified page, and locks flash again.
-*/
-static uint8_t Flash_Memory_Write_Page(uint8_t page_number, uint16_t payload_length, uint8_t *payload)
-{
-	uint8_t Flash_Write_Status = FLASH_WRITE_SUCCESS;
-	HAL_StatusTypeDef HAL_Status = HAL_ERROR;
-
-	Flash_Memory_Erase_Pages(page_number, 1);
-	uint32_t address = FLASH_BASE + page_number * PAGESIZE;
-
-	HAL_Status = HAL_FLASH_Unlock();
-	if(HAL_Status == HAL_OK)
+	if(bl_status == BL_OK)
 	{
-		for(int i=0, j=0; i< (payload_length/4 + 1) && j < 1024; i++, j +=4)
-		{
-			uint32_t curr_payload = *((uint32_t *) (payload + j));
-			HAL_Status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + j, curr_payload);
-			if(HAL_Status == HAL_ERROR)
-			{
-				Flash_Write_Status = FLASH_WRITE_ERROR;
-				break;
-			}
-		}
-
-		HAL_Status = HAL_FLASH_Lock();
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(&slot, 1);
 	}else
 	{
-		Flash_Write_Status = FLASH_WRITE_ERROR;
+		Bootloader_Send_NAck();
 	}
 
-	return Flash_Write_Status;
+	return bl_status;
 }
 
 /**================================================================
-* @Fn- Jump_To_App_Main
-* @brief - Jumps to the main application stored in the flash memory.
-* @param [in] - uint8_t *data: Command data containing the flash page number
+* @Fn- Bootloader_Invalidate_Images
+* @brief - Drops the cached validity of the slot images overlapping some pages.
+* @param [in] - uint8_t start_page: First page about to be written or erased
+* @param [in] - uint8_t number_of_pages: Number of pages
 * @param [out] - None
 * @retval - None
-* Note- Configures the vector table and resets the stack pointer before jumping to the main application.
 */
-static void Jump_To_App_Main(uint8_t *data)
+static void Bootloader_Invalidate_Images(uint8_t start_page, uint8_t number_of_pages)
 {
-    uint8_t page_number = data[3];
-    uint32_t address = FLASH_BASE + page_number * PAGESIZE;
-
-    HAL_RCC_DeInit();
-
-    SCB->VTOR = address;
-
-    __set_MSP(*(volatile uint32_t*)address);
-
-    PFunc reset_handler = (PFunc)(*(volatile uint32_t*)(address + 4));
-    reset_handler();
+	for(uint8_t slot = 0; slot < BL_NUMBER_OF_SLOTS; slot++)
+	{
+		BL_Image_Invalidate(BL_Slot_Header_Address(slot), start_page, number_of_pages);
+	}
 }
 
 /**================================================================
-* @Fn- Bootloader_Write_Memory
-* @brief - Writes data to the flash memory as requested by the host.
-* @param [in] - uint8_t *data: Command data containing the page number and data payload
-* @param [out] - BL_Status: BL_OK if successful, BL_Error otherwise
+* @Fn- Bootloader_Swap
+* @brief - Swaps the image staged in slot B with the image of slot A.
+* @param [in] - uint8_t *data: Received data buffer (not used in this function)
+* @param [out] - BL_Status: BL_OK if the swap is complete, BL_Error otherwise
 * @retval - BL_Status (Bootloader operation status)
-* Note- Sends an ACK or NACK based on the success of the write operation.
+* Note- For applications linked for slot A only: the staged image must be linked for slot A (see
+*       BL_Image_Check_Staged). The swap covers the larger of both images and is journaled (see
+*       Bootloader_Swap_Images), the response carries [number of pages swapped]. Slot A is active
+*       afterwards and slot B holds the previous image, a second swap goes back to it.
+*       A swap left pending by a failure is resumed instead of requested again.
 */
-static BL_Status Bootloader_Write_Memory(uint8_t *data)
+static BL_Status Bootloader_Swap(uint8_t *data)
 {
 	BL_Status bl_status = BL_Error;
-	uint8_t page_number = data[3];
+	uint32_t primary_header = BL_Slot_Header_Address(BL_SLOT_A);
+	uint32_t staged_header = BL_Slot_Header_Address(BL_SLOT_B);
+	const BL_Swap_Request *request = BL_Swap_Get_Request();
+	uint32_t number_of_pages = 0;
 
-	uint16_t payload_length = *((uint16_t *)(data + 4));;
+	// the swap writes through Flash_Memory_Write_Page, an open session is over
+	BL_Flash_Erase_Ahead_Stop();
+	session_active = 0;
 
-	if(page_number >=0 && page_number <= 127)
+	if(request == NULL && BL_Image_Check_Staged(staged_header, primary_header) == BL_OK)
 	{
-		uint8_t write_status = Flash_Memory_Write_Page(page_number, payload_length, data + 6);
+		const BL_Image_Header *staged = (const BL_Image_Header *)staged_header;
+		const BL_Image_Header *primary = (const BL_Image_Header *)primary_header;
 
-		if(write_status == FLASH_WRITE_SUCCESS)
+		number_of_pages = (BL_IMAGE_HEADER_SIZE + staged->image_length + PAGE_SIZE - 1) / PAGE_SIZE;
+		if(BL_Image_Check(primary_header, 0) == BL_OK &&
+		   (BL_IMAGE_HEADER_SIZE + primary->image_length + PAGE_SIZE - 1) / PAGE_SIZE > number_of_pages)
 		{
-			bl_status = BL_OK;
+			number_of_pages = (BL_IMAGE_HEADER_SIZE + primary->image_length + PAGE_SIZE - 1) / PAGE_SIZE;
 		}
-	}
 
-	if(bl_status == BL_OK)
+		if(number_of_pages <= BL_SWAP_MAX_PAGES &&
+		   BL_Swap_Set_Request((uint8_t)number_of_pages, staged->image_CRC) == BL_OK)
+		{
+			request = BL_Swap_Get_Request();
+		}
+	}
+
+	if(request != NULL)
+	{
+		number_of_pages = request->number_of_pages;
+		bl_status = Bootloader_Swap_Images();
+	}
+
+	if(bl_status == BL_OK)
+	{
+		uint8_t swapped_pages = (uint8_t)number_of_pages;
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(&swapped_pages, 1);
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Swap_Images
+* @brief - Carries out the pending swap request, if any.
+* @param [in] - None
+* @param [out] - BL_Status: BL_OK if no swap is pending any more, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- The request is written by BL_SWAP_CMD, or by the application itself after staging an image
+*       in slot B through the swap_request service, see BL_Swap_Set_Request. Before the first step the staged image is checked,
+*       a request for a broken image is dropped.
+*       Each step copies one page through BL_Page_Buffer with Flash_Memory_Write_Page, which erases
+*       the destination only when needed: blank pages and pages already holding the data cost no
+*       erase. Its flag is programmed in the journal once the page is written, so after a reset the
+*       swap resumes at the first step without a flag. The journal page is erased once per swap.
+*/
+static BL_Status Bootloader_Swap_Images(void)
+{
+	BL_Status bl_status = BL_OK;
+	const BL_Swap_Request *request = BL_Swap_Get_Request();
+
+	if(request != NULL)
+	{
+		uint8_t number_of_pages = (uint8_t)request->number_of_pages;
+		const BL_Image_Header *staged = (const BL_Image_Header *)BL_Slot_Header_Address(BL_SLOT_B);
+
+		if(!BL_Swap_Step_Done(0) &&
+		   (BL_Image_Check_Staged((uint32_t)staged, BL_Slot_Header_Address(BL_SLOT_A)) != BL_OK ||
+		    staged->image_CRC != request->image_CRC))
+		{
+			BL_Swap_Clear_Request();
+			return BL_Error;
+		}
+
+		for(uint16_t step = 0; step < BL_SWAP_STEPS(number_of_pages) && bl_status == BL_OK; step++)
+		{
+			if(!BL_Swap_Step_Done(step))
+			{
+				uint8_t source_page = 0;
+				uint8_t destination_page = 0;
+
+				BL_Swap_Step_Pages(step, number_of_pages, &source_page, &destination_page);
+				memcpy(BL_Page_Buffer, (const uint8_t *)(FLASH_BASE + source_page * PAGE_SIZE), PAGE_SIZE);
+
+				if(Flash_Memory_Write_Page(destination_page, PAGE_SIZE, BL_Page_Buffer) != FLASH_WRITE_SUCCESS)
+				{
+					bl_status = BL_Error;
+				}else
+				{
+					bl_status = BL_Swap_Set_Step_Done(step);
+				}
+			}
+		}
+
+		// the slot is set before the request is dropped, a reset in between sets it again
+		if(bl_status == BL_OK && BL_Slot_Get_Active() != BL_SLOT_A)
+		{
+			bl_status = BL_Slot_Set_Active(BL_SLOT_A);
+		}
+
+		if(bl_status == BL_OK)
+		{
+			bl_status = BL_Swap_Clear_Request();
+		}
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Go_TO_Address
+* @brief - Jumps to a specified memory address to execute code.
+* @param [in] - uint8_t *data: Command data containing the target address
+* @param [out] - BL_Status: BL_OK if address is valid, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- Verifies if the address is valid before jumping, sends ACK or NACK accordingly.
+*/
+static BL_Status Bootloader_Go_TO_Address(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t address = Bootloader_Get_Uint32(data + 3);
+
+	uint8_t validAddress = isValidAddress(address);
+
+	if(validAddress)
+	{
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(NULL, 0);
+		BL_UART_Flush();
+
+		PFunc function = (void *)(address+1);
+
+		function();
+	}else
+	{
+	    Bootloader_Send_NAck();
+	}
+	return bl_status;
+}
+
+
+/**================================================================
+* @Fn- Bootloader_Write_RAM
+* @brief - Copies data to the SRAM image window as requested by the host.
+* @param [in] - uint8_t *data: Command data containing the address (4 bytes), the payload length
+*                              (2 bytes) and the payload
+* @param [out] - BL_Status: BL_OK if the data was copied, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- No flash is touched, a test build is loaded within the time of its transfer. The response
+*       carries the payload length like BL_MEM_WRITE_CMD, BL_GET_CRC_CMD can check the whole image.
+*/
+static BL_Status Bootloader_Write_RAM(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t address = Bootloader_Get_Uint32(data + 3);
+	uint16_t payload_length = Bootloader_Get_Uint16(data + 7);
+
+	if(payload_length <= PAGE_SIZE && isValidRAMImageRange(address, payload_length))
+	{
+		memcpy((uint8_t *)address, data + 9, payload_length);
+		bl_status = BL_OK;
+	}
+
+	if(bl_status == BL_OK)
+	{
+		uint8_t write_report[2];
+		write_report[0] = (uint8_t)payload_length;
+		write_report[1] = (uint8_t)(payload_length >> 8);
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(write_report, sizeof(write_report));
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Execute_RAM
+* @brief - Starts an image loaded to the SRAM image window.
+* @param [in] - uint8_t *data: Command data containing the address of its vector table
+* @param [out] - BL_Status: BL_Error if the image was not started
+* @retval - BL_Status (Bootloader operation status)
+* Note- The table must be aligned to BL_RAM_IMAGE_ALIGNMENT, hold a stack pointer in the SRAM and a
+*       reset handler in the window. The command is acknowledged, then the image is started like an
+*       application from the flash: VTOR is set to the table, MSP to its stack pointer, and its reset
+*       handler is called. Its startup copies .data and clears .bss over the bootloader variables.
+*/
+static BL_Status Bootloader_Execute_RAM(uint8_t *data)
+{
+	uint32_t address = Bootloader_Get_Uint32(data + 3);
+
+	if((address % BL_RAM_IMAGE_ALIGNMENT) == 0 && isValidRAMImageRange(address, 8) &&
+	   Bootloader_Application_Valid(address))
+	{
+		// nothing queued may be flashed once the image runs
+		Bootloader_Commit_Pending_Write();
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(NULL, 0);
+		BL_UART_Flush();
+
+		Bootloader_Jump_To_Application(address, BL_BOOT_REASON_RAM, BL_BOOT_INFO_NO_SLOT, 0);
+	}
+
+	Bootloader_Send_NAck();
+
+	return BL_Error;
+}
+
+/**================================================================
+* @Fn- Flash_Memory_Erase_Pages
+* @brief - Erases a specified number of flash pages starting from a given page number.
+* @param [in] - uint8_t start_page: Starting page number for erasing
+* @param [in] - uint8_t number_of_pages: Number of pages to erase
+* @param [out] - uint8_t: Erase status (PAGE_ERASE_SUCCESS or PAGE_ERASE_ERROR)
+* @retval - uint8_t (Erase status)
+* Note- Unlocks flash, erases the specified pages, and locks flash again. The pages are erased
+*       through the registers (see BL_Flash_Erase_Page), the erase stops at the first failing page.
+*       A range reaching out of the pages open to the host is refused, see isValidPageRange.
+*/
+static uint8_t Flash_Memory_Erase_Pages(uint8_t start_page, uint8_t number_of_pages)
+{
+	uint8_t erase_status = PAGE_ERASE_SUCCESS;
+
+	if(isValidPageRange(start_page, (uint32_t)number_of_pages * PAGE_SIZE))
+	{
+		// the image loses its cached validity before the first of its pages goes
+		Bootloader_Invalidate_Images(start_page, number_of_pages);
+
+		if(BL_Flash_Unlock() == BL_OK)
+		{
+			for(uint8_t page = 0; page < number_of_pages && erase_status == PAGE_ERASE_SUCCESS; page++)
+			{
+				if(BL_Flash_Erase_Page(FLASH_BASE + (start_page + page) * PAGESIZE) != BL_OK)
+				{
+					erase_status = PAGE_ERASE_ERROR;
+				}
+			}
+		}else
+		{
+			erase_status = PAGE_ERASE_ERROR;
+		}
+		BL_Flash_Lock();
+	}else
+	{
+		erase_status = PAGE_ERASE_ERROR;
+	}
+
+	return erase_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Erase_Flash
+* @brief - Erases specified flash memory pages as requested by the host.
+* @param [in] - uint8_t *data: Command data containing start page and number of pages
+* @param [out] - BL_Status: BL_OK if successful, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- Sends an ACK or NACK depending on the success of the erase operation.
+*/
+static BL_Status Bootloader_Erase_Flash(uint8_t *data)
+{
+		BL_Status bl_status = BL_Error;
+		uint8_t start_page = data[3];
+		uint8_t number_of_pages = data[4];
+
+		// keep the erase-ahead of an update session away from these pages
+		BL_Flash_Erase_Ahead_Pause(start_page + number_of_pages - 1);
+		uint8_t erase_status = Flash_Memory_Erase_Pages(start_page, number_of_pages);
+		BL_Flash_Erase_Ahead_Resume();
+
+		if(erase_status == PAGE_ERASE_SUCCESS)
+		{
+			bl_status = BL_OK;
+		}
+
+		if(bl_status == BL_OK)
+		{
+			Bootloader_Send_Ack();
+			Bootloader_Send_Data_To_Host(NULL, 0);
+		}else
+		{
+			Bootloader_Send_NAck();
+		}
+
+		return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Mass_Erase
+* @brief - Erases the whole flash with one mass erase and writes the bootloader back.
+* @param [in] - uint8_t *data: Received data buffer (not used in this function)
+* @param [out] - BL_Status: BL_OK if the flash was erased, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- A mass erase takes about as long as a single page erase, but it wipes the bootloader too.
+*       The bootloader image is copied to the free SRAM above the heap and, when that is too small,
+*       on into the buffers idle during the command. Then the interrupts are disabled and
+*       BL_Flash_Mass_Erase runs from RAM until the bootloader is programmed back. The UART DMA
+*       keeps receiving in the meantime. The response carries the first page after the bootloader,
+*       all pages from there on are blank. The command is NACKed if the copy does not fit. A power
+*       loss before the bootloader is written back leaves the chip without a bootloader, only the
+*       SWD port or the system memory boot loader can recover it.
+*/
+static BL_Status Bootloader_Mass_Erase(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t bootloader_length = ((uint32_t)&_sidata - FLASH_BASE) + ((uint32_t)&_edata - (uint32_t)&_sdata);
+	uint32_t free_start = (uint32_t)&_end + (uint32_t)&_Min_Heap_Size;
+	uint32_t free_end = __get_MSP() - BL_MASS_ERASE_STACK_MARGIN;
+
+	// the command arguments are not used any more, the queued page was committed before this frame
+	BL_Flash_Segment bootloader_copy[] = {
+			{(const uint8_t *)free_start, (free_end > free_start) ? (free_end - free_start) & ~1UL : 0},
+			{BL_LZ_Window, sizeof(BL_LZ_Window)},
+			{BL_Page_Buffer, sizeof(BL_Page_Buffer)},
+			{BL_Buffer, sizeof(BL_Buffer)},
+	};
+	uint8_t number_of_segments = 0;
+	uint32_t copied_length = 0;
+
+	while(copied_length < bootloader_length && number_of_segments < sizeof(bootloader_copy) / sizeof(bootloader_copy[0]))
+	{
+		BL_Flash_Segment *segment = &bootloader_copy[number_of_segments++];
+		if(segment->length > bootloader_length - copied_length)
+		{
+			segment->length = bootloader_length - copied_length;
+		}
+
+		memcpy((uint8_t *)segment->data, (const uint8_t *)(FLASH_BASE + copied_length), segment->length);
+		copied_length += segment->length;
+	}
+
+	if(copied_length == bootloader_length)
+	{
+		uint8_t first_free_page = (bootloader_length + PAGE_SIZE - 1) / PAGE_SIZE;
+
+		BL_Flash_Erase_Ahead_Stop();
+		session_active = 0;
+
+		// a plain chunk of a streaming read may still be sent from the flash
+		BL_UART_Flush();
+
+		if(BL_Flash_Unlock() == BL_OK)
+		{
+			__disable_irq();
+			BL_Flash_Mass_Erase(bootloader_copy, number_of_segments);
+			__enable_irq();
+
+			BL_Flash_Lock();
+			bl_status = BL_OK;
+		}
+
+		if(bl_status == BL_OK)
+		{
+			Bootloader_Send_Ack();
+			Bootloader_Send_Data_To_Host(&first_free_page, 1);
+		}else
+		{
+			Bootloader_Send_NAck();
+		}
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Flash_Page_Halfword
+* @brief - Returns the halfword a page should hold at an offset once written with a payload.
+* @param [in] - const uint8_t *payload: The data written to the page
+* @param [in] - uint16_t payload_length: The length of the data
+* @param [in] - uint16_t offset: Even offset in the page
+* @retval - uint16_t (the halfword, the bytes past the payload are left erased)
+*/
+static uint16_t Flash_Page_Halfword(const uint8_t *payload, uint16_t payload_length, uint16_t offset)
+{
+	uint8_t low = (offset < payload_length) ? payload[offset] : 0xFF;
+	uint8_t high = (offset + 1 < payload_length) ? payload[offset + 1] : 0xFF;
+
+	return (uint16_t)(low | (high << 8));
+}
+
+/**================================================================
+* @Fn- Flash_Memory_Write_Page
+* @brief - Writes data to a specified flash page.
+* @param [in] - uint8_t page_number: The flash page number to write to
+* @param [in] - uint16_t payload_length: The length of the data to write
+* @param [in] - uint8_t *payload: The data to be written to flash
+* @param [out] - uint8_t: Write status (FLASH_WRITE_SUCCESS or FLASH_WRITE_ERROR)
+* @retval - uint8_t (Write status)
+* Note- The rest of the page after the payload is left erased. A halfword can only be programmed
+*       while it is erased, so the page is only erased if a halfword to change is not, and only the
+*       halfwords that differ from the flash are programmed: a page that already holds the data is
+*       neither erased nor programmed, and the 0xFFFF halfwords are skipped after an erase.
+*       The programming loop runs from RAM, see BL_Flash_Program. During an update session the page
+*       usually was erased ahead already, a failure is also latched for BL_END_SESSION_CMD.
+*/
+static uint8_t Flash_Memory_Write_Page(uint8_t page_number, uint16_t payload_length, uint8_t *payload)
+{
+	uint8_t Flash_Write_Status = FLASH_WRITE_SUCCESS;
+	uint32_t address = FLASH_BASE + page_number * PAGESIZE;
+	uint8_t page_changed = 0;
+	uint8_t erase_needed = 0;
+
+	BL_Flash_Erase_Ahead_Pause(page_number);
+
+	for(uint16_t offset = 0; offset < PAGE_SIZE; offset += 2)
+	{
+		uint16_t flash_halfword = *((volatile uint16_t *)(address + offset));
+		if(flash_halfword != Flash_Page_Halfword(payload, payload_length, offset))
+		{
+			page_changed = 1;
+			if(flash_halfword != 0xFFFF)
+			{
+				erase_needed = 1;
+				break;
+			}
+		}
+	}
+
+	if(page_changed)
+	{
+		Bootloader_Invalidate_Images(page_number, 1);
+	}
+
+	if(erase_needed && Flash_Memory_Erase_Pages(page_number, 1) != PAGE_ERASE_SUCCESS)
+	{
+		Flash_Write_Status = FLASH_WRITE_ERROR;
+	}else if(page_changed)
+	{
+		// the halfwords after the payload are erased, otherwise the scan above would have erased the page
+		if(BL_Flash_Unlock() != BL_OK || BL_Flash_Program(address, payload, payload_length) != BL_OK)
+		{
+			Flash_Write_Status = FLASH_WRITE_ERROR;
+		}
+		BL_Flash_Lock();
+	}
+
+	BL_Flash_Erase_Ahead_Resume();
+
+	if(Flash_Write_Status != FLASH_WRITE_SUCCESS && session_active && session_failed_page == BL_NO_FAILED_PAGE)
+	{
+		session_failed_page = page_number;
+	}
+
+	return Flash_Write_Status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Commit_Pending_Write
+* @brief - Programs the page queued by the last BL_MEM_WRITE_CMD, if any.
+* @param [in] - None
+* @param [out] - None
+* @retval - None
+* Note- The failure, if any, is latched in failed_page_number and reported with the next write response.
+*/
+static void Bootloader_Commit_Pending_Write(void)
+{
+	if(pending_page_valid)
+	{
+		pending_page_valid = 0;
+
+		uint8_t write_status = Flash_Memory_Write_Page(pending_page_number, pending_page_length, BL_Page_Buffer);
+
+		if(write_status != FLASH_WRITE_SUCCESS && failed_page_number == BL_NO_FAILED_PAGE)
+		{
+			failed_page_number = pending_page_number;
+		}
+	}
+}
+
+/**================================================================
+* @Fn- Jump_To_App_Main
+* @brief - Jumps to the main application stored in the flash memory.
+* @param [in] - uint8_t *data: Command data containing the flash page number
+* @param [out] - None
+* @retval - None
+* Note- Configures the vector table and resets the stack pointer before jumping to the main application.
+*       A page starting with a valid image header holds the vector table BL_IMAGE_HEADER_SIZE further.
+*/
+static void Jump_To_App_Main(uint8_t *data)
+{
+    uint8_t page_number = data[3];
+    uint32_t address = FLASH_BASE + page_number * PAGESIZE;
+    uint8_t slot = BL_BOOT_INFO_NO_SLOT;
+    uint32_t image_CRC = 0;
+
+    for(uint8_t i = 0; i < BL_NUMBER_OF_SLOTS; i++)
+    {
+        if(BL_Slot_First_Page(i) == page_number)
+        {
+            slot = i;
+        }
+    }
+
+    if(BL_Image_Check(address, 1) == BL_OK)
+    {
+        image_CRC = ((const BL_Image_Header *)address)->image_CRC;
+        address += BL_IMAGE_HEADER_SIZE;
+    }
+
+    Bootloader_Jump_To_Application(address, BL_BOOT_REASON_COMMAND, slot, image_CRC);
+}
+
+/**================================================================
+* @Fn- Bootloader_Jump_To_Application
+* @brief - Hands the CPU over to the application whose vector table is at an address.
+* @param [in] - uint32_t address: Address of the application vector table
+* @param [in] - uint8_t boot_reason: BL_BOOT_REASON_AUTOBOOT, _FALLBACK, _COMMAND or _RAM
+* @param [in] - uint8_t slot: Slot of the application, BL_BOOT_INFO_NO_SLOT outside the slots
+* @param [in] - uint32_t image_CRC: CRC from the validated image header, 0 without one
+* @param [out] - None
+* @retval - None
+* Note- Configures the vector table and resets the stack pointer before jumping to the main application.
+*       With BL_HANDOFF_KEEP_CLOCK the PLL clock stays and only SysTick is stopped, with
+*       BL_HANDOFF_KEEP_UART USART1 stays configured. The DMA channels are always reset and every
+*       interrupt is disabled and cleared, then the boot info block is filled (see BL_Handoff_Prepare).
+*/
+static void Bootloader_Jump_To_Application(uint32_t address, uint8_t boot_reason, uint8_t slot, uint32_t image_CRC)
+{
+    // no erase-ahead may run into the application, the FLASH interrupt handler is in the bootloader
+    BL_Flash_Erase_Ahead_Stop();
+
+    // stop the UART DMA channels before the application takes over the RAM
+#if (BL_HANDOFF_KEEP_UART == 1)
+    BL_UART_Handoff();
+#else
+    BL_UART_DeInit();
+#endif
+
+    // the CRC DMA channel is the last user of DMA1
+    BL_CRC_DeInit();
+    __HAL_RCC_DMA1_CLK_DISABLE();
+
+#if (BL_HANDOFF_KEEP_CLOCK == 1)
+    // the application starts on the PLL clock, SystemCoreClock is in the boot info block
+    BL_Clock_Stop_SysTick();
+#else
+    // hand over the reset clock tree, flash latency and a stopped SysTick
+    BL_Clock_DeInit();
+#endif
+
+    BL_Handoff_Prepare(boot_reason, slot, image_CRC);
+
+    SCB->VTOR = address;
+
+    __set_MSP(*(volatile uint32_t*)address);
+
+    PFunc reset_handler = (PFunc)(*(volatile uint32_t*)(address + 4));
+    reset_handler();
+}
+
+/**================================================================
+* @Fn- Bootloader_Application_Valid
+* @brief - Checks that an application vector table can be jumped to.
+* @param [in] - uint32_t address: Address of the application vector table
+* @param [out] - None
+* @retval - uint8_t (1 if the table is sane, 0 otherwise)
+* Note- The initial stack pointer has to be word aligned in the SRAM and the reset handler a Thumb
+*       address after the table, in the flash or for an SRAM image in the SRAM image window.
+*       An erased page fails both.
+*/
+static uint8_t Bootloader_Application_Valid(uint32_t address)
+{
+	uint8_t valid = 0;
+	uint32_t stack_pointer = *((volatile uint32_t *)address);
+	uint32_t reset_handler = *((volatile uint32_t *)(address + 4));
+	uint32_t code_end = (address >= SRAM_BASE) ? (BL_RAM_IMAGE_ADDRESS + BL_RAM_IMAGE_SIZE) : (FLASH_BASE + FLASH_SIZE);
+
+	if(stack_pointer > SRAM_BASE && stack_pointer <= (SRAM_BASE + SRAM_SIZE) && (stack_pointer & 0x3) == 0 &&
+	   (reset_handler & 0x1) && reset_handler > address && reset_handler < code_end)
+	{
+		valid = 1;
+	}
+
+	return valid;
+}
+
+/**================================================================
+* @Fn- Bootloader_Boot_Requested
+* @brief - Checks whether the application asked for the bootloader before its reset.
+* @param [in] - None
+* @param [out] - BL_Update_Request *update: Parameters of a requested update, requested is left 0 otherwise
+* @retval - uint8_t (1 if BL_BOOT_REQUEST_MAGIC or a valid update request was found, 0 otherwise)
+* Note- The backup registers survive a system reset. The magic is cleared, so the next reset
+*       starts the application again. An update request whose check register does not match is
+*       ignored, the registers may hold anything after a backup domain reset.
+*/
+static uint8_t Bootloader_Boot_Requested(BL_Update_Request *update)
+{
+	uint8_t requested = 0;
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+
+	uint16_t magic = (uint16_t)BL_BOOT_REQUEST_REGISTER;
+	uint16_t check = (uint16_t)~(magic ^ BL_UPDATE_BAUD_LOW_REGISTER ^ BL_UPDATE_BAUD_HIGH_REGISTER ^
+	                             BL_UPDATE_SLOT_REGISTER ^ BL_UPDATE_LENGTH_LOW_REGISTER ^
+	                             BL_UPDATE_LENGTH_HIGH_REGISTER);
+
+	if(magic == BL_BOOT_REQUEST_MAGIC)
+	{
+		requested = 1;
+	}else if(magic == BL_UPDATE_REQUEST_MAGIC && check == (uint16_t)BL_UPDATE_CHECK_REGISTER)
+	{
+		update->requested = 1;
+		update->baud_rate = (uint16_t)BL_UPDATE_BAUD_LOW_REGISTER | ((uint32_t)(uint16_t)BL_UPDATE_BAUD_HIGH_REGISTER << 16);
+		update->slot = (uint16_t)BL_UPDATE_SLOT_REGISTER;
+		update->image_length = (uint16_t)BL_UPDATE_LENGTH_LOW_REGISTER | ((uint32_t)(uint16_t)BL_UPDATE_LENGTH_HIGH_REGISTER << 16);
+		requested = 1;
+	}
+
+	if(requested)
+	{
+		HAL_PWR_EnableBkUpAccess();
+		BL_BOOT_REQUEST_REGISTER = 0;
+		HAL_PWR_DisableBkUpAccess();
+	}
+
+	__HAL_RCC_BKP_CLK_DISABLE();
+	__HAL_RCC_PWR_CLK_DISABLE();
+
+	return requested;
+}
+
+/**================================================================
+* @Fn- Bootloader_Prepare_Update
+* @brief - Configures the bootloader for an update requested by the application.
+* @param [in] - const BL_Update_Request *update: Parameters found in the backup registers
+* @param [out] - None
+* @retval - None
+* Note- The link is switched to the requested baud rate at once, the host opens the port at that
+*       rate and needs neither the sync window nor BL_SET_BAUD_CMD. With a slot and an image length
+*       the pages the image will cover are erased in the background while the host connects. The
+*       BL_BEGIN_SESSION_CMD of the host restarts the erase-ahead on the same range and skips the
+*       pages already erased. A parameter out of range is ignored.
+*/
+static void Bootloader_Prepare_Update(const BL_Update_Request *update)
+{
+	if(update->baud_rate != 0 && BL_UART_Check_Baud_Rate(update->baud_rate) == BL_OK)
+	{
+		BL_UART_Set_Baud_Rate(update->baud_rate);
+	}
+
+	if(update->slot < BL_NUMBER_OF_SLOTS && update->image_length > 0 &&
+	   update->image_length <= BL_SLOT_PAGES * PAGE_SIZE)
+	{
+		uint8_t start_page = BL_Slot_First_Page((uint8_t)update->slot);
+		uint8_t number_of_pages = (uint8_t)((update->image_length + PAGE_SIZE - 1) / PAGE_SIZE);
+
+		Bootloader_Invalidate_Images(start_page, number_of_pages);
+		BL_Flash_Erase_Ahead_Start(start_page, number_of_pages);
+	}
+}
+
+/**================================================================
+* @Fn- Bootloader_Write_Memory
+* @brief - Queues a page of data to be written to the flash memory as requested by the host.
+* @param [in] - uint8_t *data: Command data containing the page number and data payload
+* @param [out] - BL_Status: BL_OK if the page was accepted, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- The page is only copied and acknowledged here, it is programmed while the host sends the next
+*       frame. The response carries the payload length, then the status and number of the first queued
+*       page that failed since the previous response. A zero length payload flushes the queued page
+*       first, so the host uses it after the last page to get the final status.
+*/
+static BL_Status Bootloader_Write_Memory(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t page_number = data[3];
+
+	uint16_t payload_length = Bootloader_Get_Uint16(data + 4);
+
+	if(payload_length == 0)
+	{
+		Bootloader_Commit_Pending_Write();
+		bl_status = BL_OK;
+	}else if(payload_length <= PAGE_SIZE && isValidPageRange(page_number, payload_length))
+	{
+		// the buffer is free: the previous page was committed before this frame was received
+		memset(BL_Page_Buffer, 0xFF, PAGE_SIZE);
+		memcpy(BL_Page_Buffer, data + 6, payload_length);
+
+		pending_page_number = page_number;
+		pending_page_length = payload_length;
+		pending_page_valid = 1;
+		bl_status = BL_OK;
+	}
+
+	if(bl_status == BL_OK)
+	{
+		uint8_t write_report[4];
+		write_report[0] = (uint8_t)payload_length;
+		write_report[1] = (uint8_t)(payload_length >> 8);
+		write_report[2] = (failed_page_number == BL_NO_FAILED_PAGE) ? FLASH_WRITE_SUCCESS : FLASH_WRITE_ERROR;
+		write_report[3] = failed_page_number;
+		failed_page_number = BL_NO_FAILED_PAGE;
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(write_report, sizeof(write_report));
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Fill_Pages
+* @brief - Fills a range of flash pages with a repeated 32-bit pattern.
+* @param [in] - uint8_t *data: Command data containing the start page, the number of pages
+*                              and the pattern (4 bytes)
+* @param [out] - BL_Status: BL_OK if all pages were written, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- Lets the host send the constant pages of an image, padding in particular, in one frame.
+*       The pages go through Flash_Memory_Write_Page, so a page already holding the pattern is left
+*       alone and a 0xFFFFFFFF pattern only erases. The response carries [status][first failed page].
+*/
+static BL_Status Bootloader_Fill_Pages(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t start_page = data[3];
+	uint8_t number_of_pages = data[4];
+	uint32_t pattern = Bootloader_Get_Uint32(data + 5);
+
+	if(isValidPageRange(start_page, (uint32_t)number_of_pages * PAGE_SIZE))
+	{
+		uint8_t fill_report[2] = {FLASH_WRITE_SUCCESS, BL_NO_FAILED_PAGE};
+
+		// the buffer is free: the queued page was committed before this frame was received
+		for(uint16_t i = 0; i < PAGE_SIZE / 4; i++)
+		{
+			((uint32_t *)BL_Page_Buffer)[i] = pattern;
+		}
+
+		for(uint8_t page_number = start_page; page_number < start_page + number_of_pages; page_number++)
+		{
+			if(Flash_Memory_Write_Page(page_number, PAGE_SIZE, BL_Page_Buffer) != FLASH_WRITE_SUCCESS)
+			{
+				fill_report[0] = FLASH_WRITE_ERROR;
+				fill_report[1] = page_number;
+				break;
+			}
+		}
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(fill_report, sizeof(fill_report));
+
+		if(fill_report[0] == FLASH_WRITE_SUCCESS)
+		{
+			bl_status = BL_OK;
+		}
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Begin_Session
+* @brief - Opens an update session for an image and starts erasing its pages in the background.
+* @param [in] - uint8_t *data: Command data containing the start page, the image length (4 bytes)
+*                              and the CRC of the image (4 bytes)
+* @param [out] - BL_Status: BL_OK if the session was opened, BL_Error if the image does not fit
+* @retval - BL_Status (Bootloader operation status)
+* Note- The pages are erased by the FLASH interrupt while the writes of the image are received,
+*       any write command can be used within the session. A session still open is replaced.
+*       The image must start at slot A or above (see isValidPageRange), the erase-ahead would
+*       otherwise erase the running bootloader.
+*/
+static BL_Status Bootloader_Begin_Session(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t start_page = data[3];
+	uint32_t image_length = Bootloader_Get_Uint32(data + 4);
+	uint32_t number_of_pages = (image_length + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	if(isValidPageRange(start_page, image_length))
+	{
+		session_active = 1;
+		session_start_page = start_page;
+		session_image_length = image_length;
+		session_image_CRC = Bootloader_Get_Uint32(data + 8);
+		session_failed_page = BL_NO_FAILED_PAGE;
+
+		// the erase-ahead bypasses Flash_Memory_Erase_Pages, a previous session must not be erasing
+		BL_Flash_Erase_Ahead_Stop();
+		Bootloader_Invalidate_Images(start_page, number_of_pages);
+		BL_Flash_Erase_Ahead_Start(start_page, number_of_pages);
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(NULL, 0);
+		bl_status = BL_OK;
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_End_Session
+* @brief - Closes the update session and reports whether the image is in the flash.
+* @param [in] - uint8_t *data: Received data buffer (not used in this function)
+* @param [out] - BL_Status: BL_OK if the image was written and its CRC matches, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- Stops the erase-ahead and checks the CRC of the flash range against the announced one.
+*       The response carries [status][first failed page] like the bulk write, it is NACKed
+*       without an open session.
+*/
+static BL_Status Bootloader_End_Session(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+
+	if(session_active)
+	{
+		uint8_t session_report[2] = {FLASH_WRITE_SUCCESS, session_failed_page};
+
+		BL_Flash_Erase_Ahead_Stop();
+		session_active = 0;
+
+		if(session_failed_page != BL_NO_FAILED_PAGE)
+		{
+			session_report[0] = FLASH_WRITE_ERROR;
+		}else if(BL_CRC_Calculate((uint8_t *)(FLASH_BASE + session_start_page * PAGE_SIZE), session_image_length) != session_image_CRC)
+		{
+			session_report[0] = BL_BULK_CRC_ERROR;
+		}
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(session_report, sizeof(session_report));
+
+		if(session_report[0] == FLASH_WRITE_SUCCESS)
+		{
+			bl_status = BL_OK;
+		}
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Write_Memory_Bulk
+* @brief - Receives an image of any number of pages as one raw stream and flashes it page by page.
+* @param [in] - uint8_t *data: Command data containing the start page, the image length (4 bytes)
+*                              and the CRC of the whole image (4 bytes)
+* @param [out] - BL_Status: BL_OK if the whole image was written and its CRC matches, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- The announce is answered with [ACK][BL_BULK_CREDIT_PAGES], then the host streams the image
+*       without framing, at most that many pages ahead. Each page is copied out of the UART ring into
+*       BL_Page_Buffer, acknowledged with one BL_BULK_CREDIT byte, added to the CRC and flashed while the
+*       DMA keeps receiving the following pages. The stream ends with one more response carrying
+*       [status][first failed page].
+*/
+static BL_Status Bootloader_Write_Memory_Bulk(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t start_page = data[3];
+	uint32_t total_length = Bootloader_Get_Uint32(data + 4);
+	uint32_t host_CRC = Bootloader_Get_Uint32(data + 8);
+	uint32_t number_of_pages = (total_length + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	if(isValidPageRange(start_page, total_length))
+	{
+		uint8_t credit_pages = BL_BULK_CREDIT_PAGES;
+		uint8_t credit = BL_BULK_CREDIT;
+		uint8_t write_status = FLASH_WRITE_SUCCESS;
+		uint8_t failed_page = BL_NO_FAILED_PAGE;
+		uint32_t MCU_CRC = 0;
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(&credit_pages, 1);
+
+		BL_CRC_Reset();
+		for(uint32_t page_index = 0; page_index < number_of_pages; page_index++)
+		{
+			uint8_t page_number = start_page + page_index;
+			uint32_t offset = page_index * PAGE_SIZE;
+			uint16_t page_length = (total_length - offset > PAGE_SIZE) ? PAGE_SIZE : (uint16_t)(total_length - offset);
+
+			memset(BL_Page_Buffer, 0xFF, PAGE_SIZE);
+			if(BL_UART_Receive_Data(BL_Page_Buffer, page_length, BL_BULK_TIMEOUT) != BL_OK)
+			{
+				write_status = BL_BULK_STREAM_ERROR;
+				if(failed_page == BL_NO_FAILED_PAGE)
+				{
+					failed_page = page_number;
+				}
+				break;
+			}
+
+			// the page left the UART ring, the host may send one more
+			BL_UART_Transmit(&credit, 1);
+
+			MCU_CRC = BL_CRC_Accumulate(BL_Page_Buffer, page_length);
+
+			if(Flash_Memory_Write_Page(page_number, page_length, BL_Page_Buffer) != FLASH_WRITE_SUCCESS)
+			{
+				if(failed_page == BL_NO_FAILED_PAGE)
+				{
+					write_status = FLASH_WRITE_ERROR;
+					failed_page = page_number;
+				}
+			}
+		}
+
+		if(write_status == FLASH_WRITE_SUCCESS && MCU_CRC != host_CRC)
+		{
+			write_status = BL_BULK_CRC_ERROR;
+		}
+
+		uint8_t bulk_report[2] = {write_status, failed_page};
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(bulk_report, sizeof(bulk_report));
+
+		if(write_status == FLASH_WRITE_SUCCESS)
+		{
+			bl_status = BL_OK;
+		}
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_LZ_Read_Byte
+* @brief - Returns the next byte of the compressed stream of a compressed write.
+* @param [in] - BL_LZ_Stream *stream: State of the compressed write
+* @retval - uint8_t (the byte, 0 once the stream is corrupted or stalled)
+* Note- The stream is taken out of the receive ring in blocks of BL_LZ_BLOCK_SIZE bytes into
+*       BL_Buffer, each block is acknowledged with one BL_BULK_CREDIT byte. Reading past the
+*       announced compressed length marks the stream corrupted.
+*/
+static uint8_t Bootloader_LZ_Read_Byte(BL_LZ_Stream *stream)
+{
+	uint8_t credit = BL_BULK_CREDIT;
+
+	if(stream->corrupted || stream->stalled)
+	{
+		return 0;
+	}
+
+	if(stream->block_index == stream->block_length)
+	{
+		if(stream->input_remaining == 0)
+		{
+			stream->corrupted = 1;
+			return 0;
+		}
+
+		stream->block_length = (stream->input_remaining > BL_LZ_BLOCK_SIZE) ? BL_LZ_BLOCK_SIZE : (uint16_t)stream->input_remaining;
+		stream->block_index = 0;
+		if(BL_UART_Receive_Data(BL_Buffer, stream->block_length, BL_BULK_TIMEOUT) != BL_OK)
+		{
+			stream->stalled = 1;
+			return 0;
+		}
+
+		// the block left the UART ring, the host may send one more
+		BL_UART_Transmit(&credit, 1);
+		stream->input_remaining -= stream->block_length;
+	}
+
+	return BL_Buffer[stream->block_index++];
+}
+
+/**================================================================
+* @Fn- Bootloader_LZ_Read_Length
+* @brief - Reads a literal or match length of an LZ4 sequence.
+* @param [in] - BL_LZ_Stream *stream: State of the compressed write
+* @param [in] - uint8_t nibble: Length nibble of the sequence token
+* @retval - uint32_t (the length, without BL_LZ_MIN_MATCH for a match)
+* Note- A nibble of BL_LZ_LENGTH_EXTENDED is followed by bytes added to it up to the first one below 255.
+*/
+static uint32_t Bootloader_LZ_Read_Length(BL_LZ_Stream *stream, uint8_t nibble)
+{
+	uint32_t length = nibble;
+
+	if(nibble == BL_LZ_LENGTH_EXTENDED)
+	{
+		uint8_t extra = 0;
+		do
+		{
+			extra = Bootloader_LZ_Read_Byte(stream);
+			length += extra;
+		}while(extra == 255 && length <= stream->image_length);
+	}
+
+	return length;
+}
+
+/**================================================================
+* @Fn- Bootloader_LZ_Write_Byte
+* @brief - Appends a decompressed byte to the window and the page buffer.
+* @param [in] - BL_LZ_Stream *stream: State of the compressed write
+* @param [in] - uint8_t byte: Decompressed byte
+* @retval - None
+* Note- A full page, or the last one of the image padded with 0xFF, is added to the image CRC and
+*       flashed from BL_Page_Buffer while the UART DMA keeps receiving the stream.
+*/
+static void Bootloader_LZ_Write_Byte(BL_LZ_Stream *stream, uint8_t byte)
+{
+	uint16_t page_offset = stream->output_length % PAGE_SIZE;
+
+	BL_LZ_Window[stream->output_length & (BL_LZ_WINDOW_SIZE - 1)] = byte;
+	BL_Page_Buffer[page_offset] = byte;
+	stream->output_length++;
+
+	if(page_offset == PAGE_SIZE - 1 || stream->output_length == stream->image_length)
+	{
+		uint8_t page_number = stream->start_page + (stream->output_length - 1) / PAGE_SIZE;
+		uint16_t page_length = page_offset + 1;
+
+		stream->image_CRC = BL_CRC_Accumulate(BL_Page_Buffer, page_length);
+		memset(BL_Page_Buffer + page_length, 0xFF, PAGE_SIZE - page_length);
+
+		if(Flash_Memory_Write_Page(page_number, page_length, BL_Page_Buffer) != FLASH_WRITE_SUCCESS)
+		{
+			if(stream->failed_page == BL_NO_FAILED_PAGE)
+			{
+				stream->write_status = FLASH_WRITE_ERROR;
+				stream->failed_page = page_number;
+			}
+		}
+	}
+}
+
+/**================================================================
+* @Fn- Bootloader_LZ_Decompress
+* @brief - Decompresses an LZ4 block stream into flash pages.
+* @param [in] - BL_LZ_Stream *stream: State of the compressed write
+* @retval - None
+* Note- Each sequence is a token (literal length << 4 | match length - BL_LZ_MIN_MATCH), the
+*       extra literal length bytes, the literals, a 16-bit match offset and the extra match length
+*       bytes. The stream ends with the literals completing the image. Matches reaching back more
+*       than BL_LZ_WINDOW_SIZE bytes, or beyond the image, mark the stream corrupted.
+*/
+static void Bootloader_LZ_Decompress(BL_LZ_Stream *stream)
+{
+	while(stream->output_length < stream->image_length && !stream->corrupted && !stream->stalled)
+	{
+		uint8_t token = Bootloader_LZ_Read_Byte(stream);
+		uint32_t literal_length = Bootloader_LZ_Read_Length(stream, token >> 4);
+
+		if(literal_length > stream->image_length - stream->output_length)
+		{
+			stream->corrupted = 1;
+			break;
+		}
+
+		for(uint32_t i = 0; i < literal_length; i++)
+		{
+			uint8_t literal = Bootloader_LZ_Read_Byte(stream);
+			if(stream->corrupted || stream->stalled)
+			{
+				break;
+			}
+			Bootloader_LZ_Write_Byte(stream, literal);
+		}
+
+		if(stream->output_length == stream->image_length || stream->corrupted || stream->stalled)
+		{
+			break;
+		}
+
+		uint16_t offset = Bootloader_LZ_Read_Byte(stream);
+		offset |= (uint16_t)Bootloader_LZ_Read_Byte(stream) << 8;
+		uint32_t match_length = Bootloader_LZ_Read_Length(stream, token & 0x0F) + BL_LZ_MIN_MATCH;
+
+		if(offset == 0 || offset > BL_LZ_WINDOW_SIZE || offset > stream->output_length
+				|| match_length > stream->image_length - stream->output_length)
+		{
+			stream->corrupted = 1;
+			break;
+		}
+
+		// byte by byte, a match may overlap the bytes it produces
+		for(uint32_t i = 0; i < match_length; i++)
+		{
+			Bootloader_LZ_Write_Byte(stream, BL_LZ_Window[(stream->output_length - offset) & (BL_LZ_WINDOW_SIZE - 1)]);
+		}
+	}
+
+	// the image is complete, the stream has to be as well
+	if(stream->input_remaining != 0 || stream->block_index != stream->block_length)
+	{
+		stream->corrupted = 1;
+	}
+}
+
+/**================================================================
+* @Fn- Bootloader_Write_Memory_Compressed
+* @brief - Receives an LZ4 compressed image as one raw stream and flashes it page by page.
+* @param [in] - uint8_t *data: Command data containing the start page, the image length (4 bytes),
+*                              the compressed length (4 bytes) and the CRC of the image (4 bytes)
+* @param [out] - BL_Status: BL_OK if the whole image was written and its CRC matches, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- Works like BL_MEM_WRITE_BULK_CMD, except that the host streams the compressed image and gets
+*       one credit per BL_LZ_BLOCK_SIZE compressed bytes. The image is decompressed through
+*       BL_LZ_Window into BL_Page_Buffer and each page is flashed once complete. A stream that does
+*       not decode is still received to its end, so the next frame is found, and reported with
+*       BL_BULK_STREAM_ERROR and the page it broke in.
+*/
+static BL_Status Bootloader_Write_Memory_Compressed(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	BL_LZ_Stream stream = {0};
+	stream.start_page = data[3];
+	stream.image_length = Bootloader_Get_Uint32(data + 4);
+	stream.input_remaining = Bootloader_Get_Uint32(data + 8);
+	uint32_t host_CRC = Bootloader_Get_Uint32(data + 12);
+	uint32_t number_of_pages = (stream.image_length + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	if(stream.input_remaining > 0 && isValidPageRange(stream.start_page, stream.image_length))
 	{
+		uint8_t credit_blocks = BL_BULK_CREDIT_PAGES;
+		uint8_t credit = BL_BULK_CREDIT;
+		stream.write_status = FLASH_WRITE_SUCCESS;
+		stream.failed_page = BL_NO_FAILED_PAGE;
+
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(&credit_blocks, 1);
+
+		BL_CRC_Reset();
+		Bootloader_LZ_Decompress(&stream);
+
+		if(stream.corrupted || stream.stalled)
+		{
+			// a page that failed to program comes before the one the stream broke in
+			uint32_t broken_page_index = stream.output_length / PAGE_SIZE;
+			stream.write_status = BL_BULK_STREAM_ERROR;
+			if(stream.failed_page == BL_NO_FAILED_PAGE)
+			{
+				stream.failed_page = stream.start_page + ((broken_page_index < number_of_pages) ? broken_page_index : number_of_pages - 1);
+			}
+
+			// take in the rest of the stream, the host sends it all before waiting for the report
+			while(!stream.stalled && stream.input_remaining > 0)
+			{
+				uint16_t block_length = (stream.input_remaining > BL_LZ_BLOCK_SIZE) ? BL_LZ_BLOCK_SIZE : (uint16_t)stream.input_remaining;
+				if(BL_UART_Receive_Data(BL_Buffer, block_length, BL_BULK_TIMEOUT) != BL_OK)
+				{
+					break;
+				}
+				BL_UART_Transmit(&credit, 1);
+				stream.input_remaining -= block_length;
+			}
+		}else if(stream.write_status == FLASH_WRITE_SUCCESS && stream.image_CRC != host_CRC)
+		{
+			stream.write_status = BL_BULK_CRC_ERROR;
+		}
+
+		uint8_t compressed_report[2] = {stream.write_status, stream.failed_page};
 		Bootloader_Send_Ack();
-		Bootloader_Send_Data_To_Host((uint8_t *) &payload_length, 2);
+		Bootloader_Send_Data_To_Host(compressed_report, sizeof(compressed_report));
+
+		if(stream.write_status == FLASH_WRITE_SUCCESS)
+		{
+			bl_status = BL_OK;
+		}
 	}else
 	{
 		Bootloader_Send_NAck();
@@ -558,15 +1993,17 @@ static BL_Status Bootloader_Write_Memory(uint8_t *data)
 * @param [in] - uint8_t *data: Command data containing the start address and byte count
 * @param [out] - BL_Status: BL_OK if successful, BL_Error otherwise
 * @retval - BL_Status (Bootloader operation status)
-* Note- Sends the requested data to the host if the address is valid, otherwise sends a NACK.
+* Note- Sends the requested data to the host if the range is valid, otherwise sends a NACK.
+*       The response length is one byte, longer reads are NACKed instead of being truncated,
+*       BL_MEM_READ_STREAM_CMD reads more at once.
 */
 static BL_Status Bootloader_Read_Memory(uint8_t *data)
 {
 	BL_Status bl_status = BL_Error;
-	uint32_t address = *((uint32_t *)(data+3));
-	uint32_t number_of_bytes = *((uint32_t *)(data+7));
+	uint32_t address = Bootloader_Get_Uint32(data+3);
+	uint32_t number_of_bytes = Bootloader_Get_Uint32(data+7);
 
-	if(isValidAddress(address))
+	if(number_of_bytes <= BL_MAX_RESPONSE_LENGTH && isValidRange(address, number_of_bytes))
 	{
 		Bootloader_Send_Ack();
 		Bootloader_Send_Data_To_Host((uint8_t *)address, number_of_bytes);
@@ -579,6 +2016,181 @@ static BL_Status Bootloader_Read_Memory(uint8_t *data)
 	return bl_status;
 }
 
+/**================================================================
+* @Fn- Bootloader_RLE_Encode
+* @brief - Run-length encodes the 0x00 and 0xFF runs of a buffer.
+* @param [in] - const uint8_t *src: Data to encode
+* @param [in] - uint16_t length: Number of bytes to encode
+* @param [in] - uint8_t *dest: Encoded output, needs length + length / 128 + 1 bytes
+* @retval - uint16_t (number of encoded bytes)
+* Note- The output is a sequence of tokens: a byte below BL_RLE_RUN_FLAG is followed by that many
+*       plus one literal bytes, a byte with BL_RLE_RUN_FLAG set stands for a run of (low 6 bits + 1)
+*       bytes of 0xFF if BL_RLE_RUN_FF is set, 0x00 otherwise. Runs shorter than BL_RLE_MIN_RUN
+*       stay literal.
+*/
+static uint16_t Bootloader_RLE_Encode(const uint8_t *src, uint16_t length, uint8_t *dest)
+{
+	uint16_t in = 0;
+	uint16_t out = 0;
+	uint16_t literal_start = 0;
+
+	while(in <= length)
+	{
+		uint16_t run = 0;
+
+		if(in < length && (src[in] == 0x00 || src[in] == 0xFF))
+		{
+			run = 1;
+			while(in + run < length && src[in + run] == src[in] && run < BL_RLE_MAX_RUN)
+			{
+				run++;
+			}
+		}
+
+		if(run >= BL_RLE_MIN_RUN || in == length)
+		{
+			// emit the literals collected before the run (or the end of the buffer)
+			while(literal_start < in)
+			{
+				uint16_t count = (in - literal_start > BL_RLE_MAX_LITERAL) ? BL_RLE_MAX_LITERAL : (in - literal_start);
+				dest[out++] = (uint8_t)(count - 1);
+				memcpy(dest + out, src + literal_start, count);
+				out += count;
+				literal_start += count;
+			}
+
+			if(in == length)
+			{
+				break;
+			}
+
+			dest[out++] = BL_RLE_RUN_FLAG | ((src[in] == 0xFF) ? BL_RLE_RUN_FF : 0) | (uint8_t)(run - 1);
+			in += run;
+			literal_start = in;
+		}else
+		{
+			in += (run > 0) ? run : 1;
+		}
+	}
+
+	return out;
+}
+
+/**================================================================
+* @Fn- Bootloader_Read_Memory_Stream
+* @brief - Streams a memory range of any length to the host in CRC protected chunks.
+* @param [in] - uint8_t *data: Command data containing the start address (4 bytes), the length
+*                              (4 bytes) and the flags (BL_READ_FLAG_RLE)
+* @param [out] - BL_Status: BL_OK if the range was sent, BL_Error if it is invalid
+* @retval - BL_Status (Bootloader operation status)
+* Note- The command is answered with [ACK][4][length], then the range follows as chunks of up to
+*       BL_READ_CHUNK_SIZE bytes: [chunk length][data][CRC]. The chunk length is 16-bit, with
+*       BL_READ_CHUNK_RLE set when the data is run-length encoded, and the CRC is computed over the
+*       decoded data. Plain chunks are sent by the TX DMA straight from flash or SRAM.
+*/
+static BL_Status Bootloader_Read_Memory_Stream(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t address = Bootloader_Get_Uint32(data + 3);
+	uint32_t length = Bootloader_Get_Uint32(data + 7);
+	uint8_t flags = data[11];
+
+	if(isValidRange(address, length))
+	{
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host((uint8_t *)&length, sizeof(length));
+
+		for(uint32_t offset = 0; offset < length; offset += BL_READ_CHUNK_SIZE)
+		{
+			const uint8_t *chunk = (const uint8_t *)(address + offset);
+			uint16_t chunk_length = (length - offset > BL_READ_CHUNK_SIZE) ? BL_READ_CHUNK_SIZE : (uint16_t)(length - offset);
+			uint16_t header = chunk_length;
+			uint32_t chunk_CRC = BL_CRC_Calculate(chunk, chunk_length);
+
+			if(flags & BL_READ_FLAG_RLE)
+			{
+				// BL_Buffer is free once the arguments are read, wait for the previous chunk to leave it
+				BL_UART_Flush();
+				uint16_t encoded_length = Bootloader_RLE_Encode(chunk, chunk_length, BL_Buffer);
+				if(encoded_length < chunk_length)
+				{
+					chunk = BL_Buffer;
+					chunk_length = encoded_length;
+					header = encoded_length | BL_READ_CHUNK_RLE;
+				}
+			}
+
+			BL_UART_Transmit((uint8_t *)&header, sizeof(header));
+			BL_UART_Transmit_Direct(chunk, chunk_length);
+			BL_UART_Transmit((uint8_t *)&chunk_CRC, sizeof(chunk_CRC));
+		}
+
+		bl_status = BL_OK;
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Get_CRC
+* @brief - Sends the CRC-32 of a memory range, or one CRC-32 per page of a page range.
+* @param [in] - uint8_t *data: Command data containing the mode, then
+*                              BL_CRC_MODE_RANGE: address (4 bytes) and length (4 bytes),
+*                              BL_CRC_MODE_PAGES: start page and number of pages
+* @param [out] - BL_Status: BL_OK if the CRCs were sent, BL_Error if the range is invalid
+* @retval - BL_Status (Bootloader operation status)
+* Note- The CRCs are computed by the CRC unit fed through DMA, like the frame CRC, so the host
+*       verifies a whole image in one round trip and skips the pages that already match.
+*/
+static BL_Status Bootloader_Get_CRC(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t mode = data[3];
+
+	if(mode == BL_CRC_MODE_RANGE)
+	{
+		uint32_t address = Bootloader_Get_Uint32(data + 4);
+		uint32_t length = Bootloader_Get_Uint32(data + 8);
+
+		if(isValidRange(address, length))
+		{
+			uint32_t MCU_CRC = BL_CRC_Calculate((uint8_t *)address, length);
+
+			Bootloader_Send_Ack();
+			Bootloader_Send_Data_To_Host((uint8_t *)&MCU_CRC, sizeof(MCU_CRC));
+			bl_status = BL_OK;
+		}
+	}else if(mode == BL_CRC_MODE_PAGES)
+	{
+		uint8_t start_page = data[4];
+		uint8_t number_of_pages = data[5];
+
+		if(number_of_pages > 0 && number_of_pages <= BL_CRC_MAX_PAGES && start_page + number_of_pages <= NUM_OF_PAGES)
+		{
+			uint32_t page_CRCs[BL_CRC_MAX_PAGES];
+
+			for(uint8_t i = 0; i < number_of_pages; i++)
+			{
+				page_CRCs[i] = BL_CRC_Calculate((uint8_t *)(FLASH_BASE + (start_page + i) * PAGE_SIZE), PAGE_SIZE);
+			}
+
+			Bootloader_Send_Ack();
+			Bootloader_Send_Data_To_Host((uint8_t *)page_CRCs, number_of_pages * sizeof(uint32_t));
+			bl_status = BL_OK;
+		}
+	}
+
+	if(bl_status != BL_OK)
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
 /**================================================================
 * @Fn- Bootloader_Set_Read_Protection_Level
 * @brief - Sets the Read Protection (RDP) level of the flash memory.
@@ -600,6 +2212,10 @@ static BL_Status Bootloader_Set_Read_Protection_Level(uint8_t *data)
 		HAL_FLASHEx_OBGetConfig(&pOBInit);
 		pOBInit.RDPLevel = RDP_level;
 
+		// the option bytes erase would run into the erase-ahead of an open session
+		BL_Flash_Erase_Ahead_Stop();
+		session_active = 0;
+
 		HAL_Status = HAL_FLASH_Unlock();
 		if(HAL_Status == HAL_OK)
 		{
@@ -661,6 +2277,7 @@ static BL_Status Bootloader_Set_Read_Protection_Level(uint8_t *data)
 	{
 		Bootloader_Send_Ack();
 		Bootloader_Send_Data_To_Host(NULL, 0);
+		BL_UART_Flush();
 
 		// force the reload of the options bytes
 		HAL_FLASH_OB_Launch();
@@ -671,6 +2288,72 @@ static BL_Status Bootloader_Set_Read_Protection_Level(uint8_t *data)
 	return bl_status;
 }
 
+/**================================================================
+* @Fn- Bootloader_Set_Baud_Rate
+* @brief - Switches the host link to the baud rate proposed by the host.
+* @param [in] - uint8_t *data: Command data containing the new baud rate (4 bytes)
+* @param [out] - BL_Status: BL_OK if the link runs at the new rate, BL_Error otherwise
+* @retval - BL_Status (Bootloader operation status)
+* Note- The ACK is sent at the old rate, then USART1 is reprogrammed and the host has
+*       BL_BAUD_SYNC_TIMEOUT to send BL_BAUD_SYNC_BYTE at the new rate. Every sync byte is
+*       answered with BL_BAUD_SYNC_ACK until the line stays quiet. Without a sync byte the
+*       old rate is restored, the host falls back the same way when it gets no answer.
+*/
+static BL_Status Bootloader_Set_Baud_Rate(uint8_t *data)
+{
+	BL_Status bl_status = BL_Error;
+	uint32_t baud_rate = Bootloader_Get_Uint32(data + 3);
+	uint32_t old_baud_rate = BL_UART_Get_Baud_Rate();
+
+	if(BL_UART_Check_Baud_Rate(baud_rate) == BL_OK)
+	{
+		Bootloader_Send_Ack();
+		Bootloader_Send_Data_To_Host(NULL, 0);
+
+		BL_UART_Set_Baud_Rate(baud_rate);
+
+		bl_status = Bootloader_Sync(BL_BAUD_SYNC_TIMEOUT);
+		if(bl_status != BL_OK)
+		{
+			BL_UART_Set_Baud_Rate(old_baud_rate);
+		}
+	}else
+	{
+		Bootloader_Send_NAck();
+	}
+
+	return bl_status;
+}
+
+/**================================================================
+* @Fn- Bootloader_Sync
+* @brief - Runs the sync byte exchange with the host.
+* @param [in] - uint32_t timeout: Time in milliseconds to wait for the first sync byte
+* @param [out] - None
+* @retval - BL_Status (BL_OK if at least one sync byte was received, BL_Error otherwise)
+* Note- Every BL_BAUD_SYNC_BYTE is answered with BL_BAUD_SYNC_ACK until the line stays quiet for
+*       BL_BAUD_SYNC_QUIET, so the extra sync bytes the host sends are not taken for a frame.
+*       Other bytes are dropped.
+*/
+static BL_Status Bootloader_Sync(uint32_t timeout)
+{
+	BL_Status bl_status = BL_Error;
+	uint8_t sync_byte = 0;
+
+	while(BL_UART_Receive_Byte(&sync_byte, timeout) == BL_OK)
+	{
+		if(sync_byte == BL_BAUD_SYNC_BYTE)
+		{
+			uint8_t sync_ack = BL_BAUD_SYNC_ACK;
+			BL_UART_Transmit(&sync_ack, 1);
+			bl_status = BL_OK;
+			timeout = BL_BAUD_SYNC_QUIET;
+		}
+	}
+
+	return bl_status;
+}
+
 /**================================================================
 * @Fn           - Bootloader_CRC_Verification
 * @brief        - Verifies the integrity of the received data using CRC.
@@ -679,22 +2362,12 @@ static BL_Status Bootloader_Set_Read_Protection_Level(uint8_t *data)
 * @param [in]   - uint32_t host_CRC: CRC value calculated on the host side for comparison.
 * @param [out]  - uint8_t: Returns CRC_VERIFICATION_SUCCESS if CRC matches, or CRC_VERIFICATION_FAILED otherwise.
 * @retval       - uint8_t (CRC verification status)
-* Note          - The function accumulates the CRC using HAL_CRC_Accumulate() for the data and compares it with the host-provided CRC.
-*                 The CRC is reset after each verification using __HAL_CRC_DR_RESET().
+* Note          - The CRC is computed word by word by BL_CRC_Calculate(), the last partial word is zero-padded.
 */
 static uint8_t Bootloader_CRC_Verification(uint8_t *pData, uint16_t data_length, uint32_t host_CRC)
 {
 	uint8_t CRC_ver_status = CRC_VERIFICATION_FAILED;
-	uint32_t MCU_CRC = 0;
-	uint8_t data_counter = 0;
-
-	for(data_counter = 0; data_counter < data_length; data_counter++)
-	{
-		uint32_t data = (uint32_t)pData[data_counter];
-		MCU_CRC = HAL_CRC_Accumulate(&hcrc, &data, 1);
-	}
-
-	__HAL_CRC_DR_RESET(&hcrc);
+	uint32_t MCU_CRC = BL_CRC_Calculate(pData, data_length);
 
 	if(MCU_CRC == host_CRC)
 	{
@@ -707,3 +2380,29 @@ static uint8_t Bootloader_CRC_Verification(uint8_t *pData, uint16_t data_length,
 
 	return CRC_ver_status;
 }
+
+
+/**================================================================
+* @Fn- Bootloader_Get_Uint16
+* @brief - Reads a little-endian 16-bit field of a frame.
+* @param [in] - data: first byte of the field.
+* @retval - value of the field
+* Note- Byte by byte, as the arguments of a windowed frame sit one byte later than in a plain
+*       frame and so are not aligned.
+*/
+static uint16_t Bootloader_Get_Uint16(const uint8_t *data)
+{
+	return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+/**================================================================
+* @Fn- Bootloader_Get_Uint32
+* @brief - Reads a little-endian 32-bit field of a frame.
+* @param [in] - data: first byte of the field.
+* @retval - value of the field
+* Note- Byte by byte, see Bootloader_Get_Uint16.
+*/
+static uint32_t Bootloader_Get_Uint32(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
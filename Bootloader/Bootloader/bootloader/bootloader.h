@@ -13,17 +13,22 @@
 //-----------------------------
 #include "stm32f1xx_hal.h"
 #include "stm32f1xx_hal_conf.h"
-#include "stm32f1xx_hal_uart.h"
 #include "stm32f1xx_hal_flash.h"
 #include "stm32f1xx_hal_flash_ex.h"
 #include "stm32f1xx_hal_crc.h"
+#include "stm32f1xx_ll_bus.h"
+#include "stm32f1xx_ll_gpio.h"
+#include "stm32f1xx_ll_usart.h"
+#include "stm32f1xx_ll_dma.h"
+#include "stm32f1xx_ll_crc.h"
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdarg.h>
+#include <string.h>
 
 
 
-extern UART_HandleTypeDef huart1;
 extern CRC_HandleTypeDef hcrc;
 
 //-----------------------------
@@ -61,10 +66,60 @@ extern CRC_HandleTypeDef hcrc;
 // @brief Bootloader command to change read protection level.
 #define BL_CHANGE_RDP_Level_CMD     0x19
 
+// @brief Bootloader command to switch the UART to another baud rate.
+#define BL_SET_BAUD_CMD             0x1A
 
+// @brief Bootloader command to write an image of several pages streamed after the command.
+#define BL_MEM_WRITE_BULK_CMD       0x1B
 
-// @brief UART interface for bootloader communication.
-#define BL_UART                   &huart1
+// @brief Bootloader command to get the CRC of a memory range or of each page of a page range.
+#define BL_GET_CRC_CMD              0x1C
+
+// @brief Bootloader command to stream a memory range of any length.
+#define BL_MEM_READ_STREAM_CMD      0x1D
+
+// @brief Bootloader command to write an LZ4 compressed image streamed after the command.
+#define BL_MEM_WRITE_COMPRESSED_CMD 0x1E
+
+// @brief Bootloader command to fill flash pages with a repeated 32-bit pattern.
+#define BL_FILL_PAGES_CMD           0x1F
+
+// @brief Bootloader command to announce an image and erase its pages ahead of the writes.
+#define BL_BEGIN_SESSION_CMD        0x20
+
+// @brief Bootloader command to end an update session and get its final status.
+#define BL_END_SESSION_CMD          0x21
+
+// @brief Bootloader command to mass erase the flash, keeping the bootloader itself.
+#define BL_MASS_ERASE_CMD           0x22
+
+// @brief Bootloader command to get the image header of an application slot.
+#define BL_GET_IMAGE_HEADER_CMD     0x23
+
+// @brief Bootloader command to get the active application slot and the slot layout.
+#define BL_GET_SLOT_CMD             0x24
+
+// @brief Bootloader command to make an application slot the active one.
+#define BL_SET_SLOT_CMD             0x25
+
+// @brief Bootloader command to swap the image staged in slot B into slot A.
+#define BL_SWAP_CMD                 0x26
+
+// @brief Bootloader command to write data to the SRAM image window.
+#define BL_RAM_WRITE_CMD            0x27
+
+// @brief Bootloader command to start an image loaded to the SRAM.
+#define BL_RAM_EXEC_CMD             0x28
+
+
+
+// @brief UART interface for bootloader communication and its DMA channels, driven through the LL layer by bl_uart.c.
+#define BL_UART_INSTANCE          USART1
+#define BL_UART_DMA               DMA1
+#define BL_UART_RX_DMA_CHANNEL    LL_DMA_CHANNEL_5
+#define BL_UART_TX_DMA_CHANNEL    LL_DMA_CHANNEL_4
+// @brief Baud rate BL_UART_INSTANCE starts with after reset.
+#define BL_UART_BAUD_RATE         115200
 
 
 // @brief Bootloader acknowledgment code.
@@ -72,6 +127,16 @@ extern CRC_HandleTypeDef hcrc;
 // @brief Bootloader not-acknowledgment code.
 #define BL_NACK                     0x00
 
+//-----------------------------
+// Frame Format Macros
+//-----------------------------
+// @brief Set in the length field of a windowed frame: [length][sequence][command][arguments][CRC].
+#define BL_WINDOW_FRAME_FLAG      0x8000
+// @brief Mask extracting the number of bytes following the length field.
+#define BL_FRAME_LENGTH_MASK      0x7FFF
+// @brief Number of windowed frames the host may send before waiting for a response.
+#define BL_WINDOW_SIZE                 3
+
 //-----------------------------
 // Version Information Macros
 //-----------------------------
@@ -80,7 +145,7 @@ extern CRC_HandleTypeDef hcrc;
 // @brief Bootloader software major version.
 #define BL_SW_MAJOR_VERSION            1
 // @brief Bootloader software minor version.
-#define BL_SW_MINOR_VERSION            0
+#define BL_SW_MINOR_VERSION            1
 // @brief Bootloader software patch version.
 #define BL_SW_PATCH_VERSION            0
 
@@ -88,12 +153,12 @@ extern CRC_HandleTypeDef hcrc;
 // Flash Memory and Page Information
 //-----------------------------
 // @brief Number of flash memory pages.
-#define NUM_OF_PAGES                 128
+#define NUM_OF_PAGES                  64
 // @brief Size of each flash memory page in bytes.
 #define PAGE_SIZE                   1024
 
 // @brief Total flash memory size in bytes.
-#define FLASH_SIZE                0x20000  // (128 kB)
+#define FLASH_SIZE                0x10000  // (64 kB of the STM32F103C8)
 // @brief Total SRAM memory size in bytes.
 #define SRAM_SIZE                  0x5000  // (20 kB)
 
@@ -115,6 +180,12 @@ extern CRC_HandleTypeDef hcrc;
 #define FLASH_WRITE_ERROR             0x0
 // @brief Status indicating flash write success.
 #define FLASH_WRITE_SUCCESS           0x1
+// @brief Page number reported when no queued page write has failed.
+#define BL_NO_FAILED_PAGE            0xFF
+// @brief Bulk write status: the stream stalled or was corrupted before the image was complete.
+#define BL_BULK_STREAM_ERROR          0x2
+// @brief Bulk write status: all pages were written but the image CRC does not match.
+#define BL_BULK_CRC_ERROR             0x3
 
 //-----------------------------
 // CRC Verification Status Macros
@@ -131,6 +202,235 @@ extern CRC_HandleTypeDef hcrc;
 #define BL_BUFFER_LENGTH             1050
 // @brief Maximum UART timeout for bootloader operations in milliseconds.
 #define BL_MAX_TIMEOUT             100000
+// @brief Time in milliseconds a partially received frame may stall before it is dropped.
+#define BL_FRAME_TIMEOUT              100
+// @brief Size of the DMA circular receive buffer in bytes (must be a power of two).
+#define BL_UART_RX_RING_SIZE         4096
+// @brief Size of each of the two DMA transmit buffers in bytes.
+#define BL_UART_TX_BUFFER_SIZE        256
+// @brief Number of words from which the CRC is fed by DMA instead of the CPU.
+#define BL_CRC_DMA_MIN_WORDS           16
+
+//-----------------------------
+// CRC Command
+//-----------------------------
+// @brief BL_GET_CRC_CMD mode: one CRC over [address, address + length).
+#define BL_CRC_MODE_RANGE               0
+// @brief BL_GET_CRC_CMD mode: one CRC per flash page.
+#define BL_CRC_MODE_PAGES               1
+// @brief Most page CRCs in one response (4 bytes each, the response length is one byte).
+#define BL_CRC_MAX_PAGES               63
+
+//-----------------------------
+// Streaming Read
+//-----------------------------
+// @brief Most data bytes in a normal response (the length is sent in one byte).
+#define BL_MAX_RESPONSE_LENGTH        255
+// @brief Bytes of memory per chunk of a streaming read.
+#define BL_READ_CHUNK_SIZE           1024
+// @brief BL_MEM_READ_STREAM_CMD flag: run-length encode the 0x00/0xFF runs.
+#define BL_READ_FLAG_RLE             0x01
+// @brief Set in a chunk length when the chunk data is run-length encoded.
+#define BL_READ_CHUNK_RLE          0x8000
+// @brief RLE token flag for a run, the low 6 bits hold the run length minus one.
+#define BL_RLE_RUN_FLAG              0x80
+// @brief RLE run token bit selecting 0xFF instead of 0x00.
+#define BL_RLE_RUN_FF                0x40
+// @brief Shortest run worth a token, shorter ones stay literal.
+#define BL_RLE_MIN_RUN                  3
+// @brief Longest run of one token.
+#define BL_RLE_MAX_RUN                 64
+// @brief Longest literal of one token.
+#define BL_RLE_MAX_LITERAL            128
+
+#if (BL_READ_CHUNK_SIZE + BL_READ_CHUNK_SIZE / BL_RLE_MAX_LITERAL + 1 > BL_BUFFER_LENGTH)
+#error "BL_Buffer can not hold an RLE encoded chunk"
+#endif
+
+//-----------------------------
+// Bulk Write
+//-----------------------------
+// @brief Pages the host may stream ahead of the credits (must fit in BL_UART_RX_RING_SIZE).
+#define BL_BULK_CREDIT_PAGES            3
+// @brief Byte sent each time a streamed page has been taken out of the receive ring.
+#define BL_BULK_CREDIT               0x43
+// @brief Time in milliseconds the stream may stall before the bulk write is aborted.
+#define BL_BULK_TIMEOUT              1000
+
+//-----------------------------
+// Compressed Write
+//-----------------------------
+// @brief Decompression window in bytes, the farthest a match may reach back (must be a power of two).
+#define BL_LZ_WINDOW_SIZE            2048
+// @brief Compressed bytes taken out of the receive ring per credit (BL_BULK_CREDIT_PAGES of them are in flight).
+#define BL_LZ_BLOCK_SIZE             1024
+// @brief Shortest match of an LZ4 sequence.
+#define BL_LZ_MIN_MATCH                 4
+// @brief Length nibble value announcing extra length bytes.
+#define BL_LZ_LENGTH_EXTENDED          15
+
+#if (BL_LZ_BLOCK_SIZE > BL_BUFFER_LENGTH)
+#error "BL_Buffer can not hold a compressed block"
+#endif
+
+//-----------------------------
+// Mass Erase
+//-----------------------------
+// @brief Stack in bytes kept free below the stack pointer when the bootloader is copied to SRAM.
+#define BL_MASS_ERASE_STACK_MARGIN    256
+
+//-----------------------------
+// SRAM Images
+//-----------------------------
+// @brief First SRAM address an image can be loaded to, above the variables and heap of the bootloader.
+#define BL_RAM_IMAGE_ADDRESS   0x20002800
+// @brief Bytes of the SRAM image window, it ends at the bottom of the bootloader stack (_estack - _Min_Stack_Size).
+#define BL_RAM_IMAGE_SIZE          0x23C0
+// @brief Alignment of the vector table of an SRAM image, VTOR needs the table size rounded up to a power of two.
+#define BL_RAM_IMAGE_ALIGNMENT      0x200
+
+//-----------------------------
+// Application Slots
+//-----------------------------
+// @brief Number of execute-in-place application slots.
+#define BL_NUMBER_OF_SLOTS              2
+// @brief Slot A, active when no slot was ever selected.
+#define BL_SLOT_A                       0
+// @brief Slot B.
+#define BL_SLOT_B                       1
+// @brief First page of slot A (must be after the bootloader), each slot starts with its image header.
+#define BL_SLOT_A_PAGE                 24
+// @brief First page of slot B.
+#define BL_SLOT_B_PAGE                 42
+// @brief Pages of each slot.
+#define BL_SLOT_PAGES                  18
+// @brief First of the two metadata pages holding the active slot records.
+#define BL_SLOT_META_PAGE              62
+// @brief Number of metadata pages, the records go to one while the other is erased.
+#define BL_SLOT_META_PAGES              2
+// @brief First word of a metadata record ("SLOT").
+#define BL_SLOT_RECORD_MAGIC   0x544F4C53
+
+#if (BL_SLOT_A_PAGE + BL_SLOT_PAGES > BL_SLOT_B_PAGE || BL_SLOT_B_PAGE + BL_SLOT_PAGES > BL_SLOT_META_PAGE)
+#error "the application slots overlap"
+#endif
+#if (BL_SLOT_META_PAGE + BL_SLOT_META_PAGES > NUM_OF_PAGES)
+#error "the slot metadata is past the end of the flash"
+#endif
+
+//-----------------------------
+// Swap Upgrade
+//-----------------------------
+// @brief Page journaling a swap of slot A (primary) and slot B (secondary), between the slots and the metadata.
+#define BL_SWAP_JOURNAL_PAGE           61
+// @brief First word of a swap request at the start of the journal page ("SWAP").
+#define BL_SWAP_REQUEST_MAGIC  0x50415753
+// @brief Largest image a swap moves, in pages including the header: slot A keeps one page to move into.
+#define BL_SWAP_MAX_PAGES             (BL_SLOT_PAGES - 1)
+// @brief Value programmed into the journal flag of a completed swap step.
+#define BL_SWAP_STEP_DONE          0x0000
+
+#if (BL_SLOT_B_PAGE + BL_SLOT_PAGES > BL_SWAP_JOURNAL_PAGE || BL_SWAP_JOURNAL_PAGE >= BL_SLOT_META_PAGE)
+#error "the swap journal overlaps a slot or the slot metadata"
+#endif
+
+// @brief First page no host command or service may write or erase: the swap journal and the slot metadata
+//        are only programmed through bl_swap.c and bl_slot.c.
+#define BL_HOST_PAGE_END              BL_SWAP_JOURNAL_PAGE
+
+//-----------------------------
+// Image Header
+//-----------------------------
+// @brief Bytes reserved for the header before the vector table (keeps the table aligned for VTOR).
+#define BL_IMAGE_HEADER_SIZE        0x200
+// @brief First word of a valid image header ("BIMG").
+#define BL_IMAGE_MAGIC         0x474D4942
+// @brief Marker programmed into a header once its image passed the CRC check ("VALD").
+#define BL_IMAGE_VALID         0x444C4156
+// @brief Marker programmed over BL_IMAGE_VALID when a page of the image changes.
+#define BL_IMAGE_INVALID       0x00000000
+
+//-----------------------------
+// Baud Rate Negotiation
+//-----------------------------
+// @brief Lowest baud rate accepted by BL_SET_BAUD_CMD.
+#define BL_MIN_BAUD_RATE             9600
+// @brief Highest baud rate accepted by BL_SET_BAUD_CMD.
+#define BL_MAX_BAUD_RATE          2000000
+// @brief Maximum baud rate error in 1/1000 of the requested rate.
+#define BL_BAUD_MAX_ERROR              20
+// @brief Time in milliseconds the host has to send the first sync byte at the new rate.
+#define BL_BAUD_SYNC_TIMEOUT          500
+// @brief Time in milliseconds without sync byte that ends the sync exchange.
+#define BL_BAUD_SYNC_QUIET             50
+// @brief Byte sent by the host at the new rate.
+#define BL_BAUD_SYNC_BYTE            0x5A
+// @brief Byte the bootloader answers each sync byte with.
+#define BL_BAUD_SYNC_ACK             0xA5
+
+//-----------------------------
+// Autoboot
+//-----------------------------
+// @brief 1: at reset the application is started unless the bootloader is asked to stay, 0: wait for the host.
+#define BL_AUTOBOOT_ENABLE              1
+// @brief Time in milliseconds after reset the host has to send BL_BAUD_SYNC_BYTE to keep the bootloader.
+#define BL_AUTOBOOT_WINDOW             10
+// @brief 1: the boot pin at BL_BOOT_PIN_ACTIVE keeps the bootloader, 0: the pin is not sampled.
+#define BL_BOOT_PIN_ENABLE              1
+// @brief Boot pin, PB2 is BOOT1 and has a jumper on most boards.
+#define BL_BOOT_PIN_PORT            GPIOB
+#define BL_BOOT_PIN            GPIO_PIN_2
+#define BL_BOOT_PIN_CLK_ENABLE()   __HAL_RCC_GPIOB_CLK_ENABLE()
+#define BL_BOOT_PIN_ACTIVE   GPIO_PIN_SET
+// @brief Backup register an application writes BL_BOOT_REQUEST_MAGIC to before a reset into the bootloader.
+#define BL_BOOT_REQUEST_REGISTER  (BKP->DR1)
+// @brief Value of BL_BOOT_REQUEST_REGISTER asking the bootloader to stay, cleared when seen.
+#define BL_BOOT_REQUEST_MAGIC      0x424C
+// @brief Value of BL_BOOT_REQUEST_REGISTER asking for an update with the parameters below, cleared when seen.
+#define BL_UPDATE_REQUEST_MAGIC    0x5544
+// @brief Baud rate of the update (low and high halves), 0 keeps the default rate.
+#define BL_UPDATE_BAUD_LOW_REGISTER    (BKP->DR2)
+#define BL_UPDATE_BAUD_HIGH_REGISTER   (BKP->DR3)
+// @brief Slot the image goes to, BL_UPDATE_NO_SLOT if no pages are to be erased ahead.
+#define BL_UPDATE_SLOT_REGISTER        (BKP->DR4)
+// @brief Bytes the host writes from the first page of the slot (low and high halves), header included.
+#define BL_UPDATE_LENGTH_LOW_REGISTER  (BKP->DR5)
+#define BL_UPDATE_LENGTH_HIGH_REGISTER (BKP->DR6)
+// @brief Complement of the XOR of DR1 to DR6, a request with another value is ignored.
+#define BL_UPDATE_CHECK_REGISTER       (BKP->DR7)
+// @brief Value of BL_UPDATE_SLOT_REGISTER for an update that is not for a slot.
+#define BL_UPDATE_NO_SLOT          0xFFFF
+
+//-----------------------------
+// Stage 0
+//-----------------------------
+// @brief 1: stage 0 starts the active slot itself when nothing asks for the bootloader, 0: stage 1 always runs.
+#define BL_STAGE0_ENABLE                1
+// @brief Places a function with stage 0 in front of the service table, compiled for size in any build.
+#define BL_STAGE0_FUNC     __attribute__((section(".stage0"), optimize("Os")))
+
+//-----------------------------
+// Clock Configuration
+//-----------------------------
+// @brief 8 MHz HSI, no PLL, zero flash wait states (configuration left by SystemClock_Config).
+#define BL_CLOCK_HSI_8MHZ              0
+// @brief HSI/2 x 16 = 64 MHz, two flash wait states, no crystal needed.
+#define BL_CLOCK_HSI_64MHZ             1
+// @brief 8 MHz HSE x 9 = 72 MHz, two flash wait states, falls back to BL_CLOCK_HSI_64MHZ without crystal.
+#define BL_CLOCK_HSE_72MHZ             2
+
+// @brief Clock the bootloader runs from.
+#define BL_CLOCK_CONFIG    BL_CLOCK_HSI_64MHZ
+
+//-----------------------------
+// Application Handoff
+//-----------------------------
+// @brief 1: the application starts on the bootloader clock (SysTick stopped), 0: on the reset clock tree.
+//        Only set it for applications that skip SystemClock_Config when BL_BOOT_INFO_CLOCK_KEPT is set,
+//        the CubeMX one fails in HAL_RCC_OscConfig while the PLL is the system clock.
+#define BL_HANDOFF_KEEP_CLOCK           0
+// @brief 1: USART1 and its pins stay enabled at the current rate (DMA and interrupts off), 0: USART1 is reset.
+#define BL_HANDOFF_KEEP_UART            0
 
 // @brief Build type (debug or release).
 #define BUILD_TYPE_DEBUG             0
@@ -152,6 +452,7 @@ typedef enum {
 * ===============================================
 */
 BL_Status Bootloader_Get_Command();
+void Bootloader_Autoboot(void);
 
 
 #endif /* BOOTLOADER_H_ */
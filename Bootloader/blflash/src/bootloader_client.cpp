@@ -0,0 +1,821 @@
+/*
+ * bootloader_client.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "bootloader_client.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <thread>
+
+#include "crc32.h"
+
+namespace blflash {
+
+namespace {
+
+constexpr uint16_t kWindowFrameFlag = 0x8000;
+// time without any response before the windowed frames in flight are sent again
+constexpr std::chrono::milliseconds kWindowTimeout(2000);
+// number of times a windowed frame is sent again before giving up on it
+constexpr int kWindowMaxRetries = 5;
+// number of passes over the pages that failed to write
+constexpr int kWriteMaxAttempts = 4;
+// erasing the whole flash takes several seconds
+constexpr std::chrono::milliseconds kEraseTimeout(10000);
+// a swap erases up to three pages per page of the images
+constexpr std::chrono::milliseconds kSwapTimeout(30000);
+
+constexpr uint8_t kBulkCredit = 0x43;
+constexpr uint8_t kBulkWriteSuccess = 0x01;
+constexpr uint8_t kNoFailedPage = 0xFF;
+// compressed bytes per credit of a compressed write
+constexpr size_t kCompressedBlockSize = 1024;
+constexpr uint8_t kCrcModeRange = 0;
+constexpr uint8_t kCrcModePages = 1;
+// page CRCs per response, 4 bytes each in a response of at most 255 bytes
+constexpr uint8_t kCrcMaxPages = 63;
+
+// bytes of memory per chunk of a streaming read
+constexpr uint32_t kReadChunkSize = 1024;
+constexpr uint8_t kReadFlagRle = 0x01;
+constexpr uint16_t kReadChunkRle = 0x8000;
+constexpr int kReadMaxRetries = 3;
+
+// a credit is sent once the page is out of the receive ring, before it is flashed
+constexpr std::chrono::milliseconds kBulkTimeout(2000);
+
+constexpr uint8_t kBaudSyncByte = 0x5A;
+constexpr uint8_t kBaudSyncAck = 0xA5;
+constexpr std::chrono::milliseconds kBaudSyncInterval(20);
+constexpr std::chrono::milliseconds kBaudSyncTimeout(500);
+// the bootloader ends the sync exchange once the line is quiet for 50 ms
+constexpr std::chrono::milliseconds kBaudSyncSettle(100);
+// the autoboot window is 10 ms, several sync bytes have to land in it
+constexpr std::chrono::milliseconds kConnectInterval(2);
+
+void putLe16(Bytes &out, uint16_t value)
+{
+	out.push_back(uint8_t(value));
+	out.push_back(uint8_t(value >> 8));
+}
+
+void putLe32(Bytes &out, uint32_t value)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		out.push_back(uint8_t(value >> shift));
+	}
+}
+
+uint32_t getLe32(const uint8_t *data)
+{
+	return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+}
+
+// Expands the 0x00/0xFF run-length encoding of a streamed chunk, see the
+// README. Returns false if the data does not decode to exactly length bytes.
+bool rleDecode(const Bytes &encoded, uint8_t *out, size_t length)
+{
+	size_t produced = 0;
+	for (size_t i = 0; i < encoded.size();) {
+		uint8_t token = encoded[i++];
+		if (token & 0x80) {
+			size_t run = size_t(token & 0x3F) + 1;
+			if (produced + run > length) {
+				return false;
+			}
+			std::fill_n(out + produced, run, (token & 0x40) ? 0xFF : 0x00);
+			produced += run;
+		} else {
+			size_t count = size_t(token) + 1;
+			if (i + count > encoded.size() || produced + count > length) {
+				return false;
+			}
+			std::copy_n(encoded.begin() + long(i), count, out + produced);
+			i += count;
+			produced += count;
+		}
+	}
+	return produced == length;
+}
+
+Bytes writePageCommand(uint8_t page, const uint8_t *data, uint16_t length)
+{
+	Bytes command = {kMemWrite, page};
+	putLe16(command, length);
+	command.insert(command.end(), data, data + length);
+	return command;
+}
+
+} // namespace
+
+BootloaderClient::BootloaderClient(SerialPort &port) : port_(port)
+{
+}
+
+void BootloaderClient::sendFrame(const Bytes &command, bool windowed, uint8_t sequence)
+{
+	// length counts everything after the length field, CRC included
+	uint8_t header[3];
+	size_t header_length = 2;
+	uint16_t length = uint16_t(command.size() + 4);
+	if (windowed) {
+		length = uint16_t((length + 1) | kWindowFrameFlag);
+		header[2] = sequence;
+		header_length = 3;
+	}
+	header[0] = uint8_t(length);
+	header[1] = uint8_t(length >> 8);
+
+	// the CRC covers the header and the command, compute it over one copy
+	Bytes covered(header, header + header_length);
+	covered.insert(covered.end(), command.begin(), command.end());
+	uint32_t crc = crc32Stm32(covered.data(), covered.size());
+	uint8_t trailer[4] = {uint8_t(crc), uint8_t(crc >> 8), uint8_t(crc >> 16), uint8_t(crc >> 24)};
+
+	struct iovec iov[3] = {
+		{header, header_length},
+		{const_cast<uint8_t *>(command.data()), command.size()},
+		{trailer, sizeof(trailer)},
+	};
+	port_.write(iov, 3);
+}
+
+Response BootloaderClient::readResponse(bool windowed, uint8_t sequence, std::chrono::milliseconds timeout)
+{
+	Response response;
+	uint8_t header[2];
+	size_t header_length = windowed ? 2 : 1;
+
+	if (port_.read(header, header_length, timeout) != header_length) {
+		throw TimeoutError("no response from the bootloader");
+	}
+	if (windowed && header[1] != sequence) {
+		throw std::runtime_error("response out of sequence");
+	}
+
+	response.ack = header[0] == kAck;
+	if (response.ack) {
+		uint8_t length = 0;
+		if (port_.read(&length, 1, timeout) != 1) {
+			throw TimeoutError("truncated response from the bootloader");
+		}
+		response.data.resize(length);
+		if (port_.read(response.data.data(), length, timeout) != length) {
+			throw TimeoutError("truncated response from the bootloader");
+		}
+	}
+
+	return response;
+}
+
+Response BootloaderClient::transact(const Bytes &command, std::chrono::milliseconds timeout)
+{
+	sendFrame(command, false, 0);
+	return readResponse(false, 0, timeout);
+}
+
+std::vector<Response> BootloaderClient::transactAll(const std::vector<Bytes> &commands,
+                                                    const ResponseCallback &on_response)
+{
+	if (window_size_ > 0) {
+		return transactWindowed(commands, on_response);
+	}
+
+	std::vector<Response> responses;
+	responses.reserve(commands.size());
+	for (size_t i = 0; i < commands.size(); i++) {
+		responses.push_back(transact(commands[i]));
+		if (on_response) {
+			on_response(i, responses.back());
+		}
+	}
+	return responses;
+}
+
+// The bootloader answers windowed frames in the order it received them, so a
+// response to a frame also tells that every older unanswered frame was lost.
+// Only NACKed and lost frames are sent again.
+std::vector<Response> BootloaderClient::transactWindowed(const std::vector<Bytes> &commands,
+                                                         const ResponseCallback &on_response)
+{
+	std::vector<Response> responses(commands.size());
+	std::vector<int> retries(commands.size(), 0);
+	std::deque<size_t> in_flight;
+	size_t next_command = 0;
+
+	auto resend = [&](size_t index) {
+		if (retries[index] < kWindowMaxRetries) {
+			retries[index]++;
+			sendFrame(commands[index], true, uint8_t(index));
+			in_flight.push_back(index);
+		} else if (on_response) {
+			on_response(index, responses[index]);
+		}
+	};
+
+	while (next_command < commands.size() || !in_flight.empty()) {
+		while (next_command < commands.size() && in_flight.size() < window_size_) {
+			sendFrame(commands[next_command], true, uint8_t(next_command));
+			in_flight.push_back(next_command);
+			next_command++;
+		}
+
+		uint8_t header[2];
+		if (port_.read(header, 2, kWindowTimeout) != 2) {
+			// nothing came back, the bootloader dropped the frames: send them all again
+			port_.discardInput();
+			std::deque<size_t> lost;
+			lost.swap(in_flight);
+			for (size_t index : lost) {
+				resend(index);
+			}
+			continue;
+		}
+
+		auto match = std::find_if(in_flight.begin(), in_flight.end(),
+		                          [&](size_t index) { return uint8_t(index) == header[1]; });
+		if (match == in_flight.end()) {
+			continue;
+		}
+
+		size_t index = *match;
+		std::deque<size_t> lost(in_flight.begin(), match);
+		in_flight.erase(in_flight.begin(), match + 1);
+
+		if (header[0] == kAck) {
+			uint8_t length = 0;
+			Response &response = responses[index];
+			if (port_.read(&length, 1, kWindowTimeout) == 1) {
+				response.data.resize(length);
+				response.data.resize(port_.read(response.data.data(), length, kWindowTimeout));
+			}
+			response.ack = response.data.size() == length;
+			if (response.ack) {
+				if (on_response) {
+					on_response(index, response);
+				}
+			} else {
+				response.data.clear();
+				resend(index);
+			}
+		} else {
+			resend(index);
+		}
+
+		for (size_t lost_index : lost) {
+			resend(lost_index);
+		}
+	}
+
+	return responses;
+}
+
+Response BootloaderClient::expect(const Bytes &command, size_t minimum_length)
+{
+	Response response = transact(command);
+	if (!response.ack) {
+		throw std::runtime_error("bootloader sent nack");
+	}
+	if (response.data.size() < minimum_length) {
+		throw std::runtime_error("short response from the bootloader");
+	}
+	return response;
+}
+
+Version BootloaderClient::getVersion()
+{
+	Response response = expect({kGetVersion}, 4);
+	Version version;
+	version.vendor_id = response.data[0];
+	version.major = response.data[1];
+	version.minor = response.data[2];
+	version.patch = response.data[3];
+	// bootloaders supporting windowed frames append their window size
+	if (response.data.size() >= 5) {
+		version.window_size = response.data[4];
+	}
+	return version;
+}
+
+Bytes BootloaderClient::getHelp()
+{
+	return expect({kGetHelp}, 0).data;
+}
+
+uint16_t BootloaderClient::getChipId()
+{
+	Response response = expect({kGetChipId}, 2);
+	return uint16_t(response.data[0] | response.data[1] << 8);
+}
+
+ImageHeader BootloaderClient::getImageHeader(uint8_t slot)
+{
+	// [valid][header as stored in flash], valid needs the image CRC to match
+	Response response = expect({kGetImageHeader, slot}, 1 + kImageHeaderLength);
+	ImageHeader header = parseImageHeader(response.data.data() + 1);
+	header.valid = response.data[0] == 1;
+	return header;
+}
+
+SlotInfo BootloaderClient::getSlots()
+{
+	// [active slot][first page of each slot][pages per slot]
+	Response response = expect({kGetSlot}, 3);
+	SlotInfo slots;
+	slots.active = response.data.front();
+	slots.first_pages.assign(response.data.begin() + 1, response.data.end() - 1);
+	slots.pages = response.data.back();
+	return slots;
+}
+
+bool BootloaderClient::setActiveSlot(uint8_t slot)
+{
+	return transact({kSetSlot, slot}).ack;
+}
+
+bool BootloaderClient::swapImages(uint8_t &swapped_pages)
+{
+	// [number of pages swapped from the start of each slot]
+	Response response = transact({kSwap}, kSwapTimeout);
+	if (!response.ack || response.data.size() != 1) {
+		return false;
+	}
+	swapped_pages = response.data[0];
+	return true;
+}
+
+uint8_t BootloaderClient::getRdpLevel()
+{
+	Response response = expect({kGetRdpStatus}, 1);
+	// the option byte reads 0xA5 for level 0, anything else is level 1
+	return response.data[0] == 0xA5 ? 0 : 1;
+}
+
+bool BootloaderClient::goToAddress(uint32_t address)
+{
+	Bytes command = {kGoToAddress};
+	putLe32(command, address);
+	return transact(command).ack;
+}
+
+bool BootloaderClient::eraseFlash(uint8_t start_page, uint8_t number_of_pages)
+{
+	return transact({kFlashErase, start_page, number_of_pages}, kEraseTimeout).ack;
+}
+
+bool BootloaderClient::massErase(uint8_t &first_free_page)
+{
+	// [first page after the bootloader], NACKed when the bootloader can not keep itself
+	Response response = transact({kMassErase}, kEraseTimeout);
+	if (!response.ack || response.data.size() != 1) {
+		return false;
+	}
+	first_free_page = response.data[0];
+	return true;
+}
+
+// The bootloader acks a page as soon as it is queued and flashes it while the
+// next one is on the wire, failures are reported in a later response as
+// [length][status][failed page]. An empty write flushes the last queued page.
+WriteResult BootloaderClient::writeImage(uint8_t start_page, const Bytes &image,
+                                         const std::function<void(size_t)> &on_progress)
+{
+	size_t number_of_pages = (image.size() + kPageSize - 1) / kPageSize;
+	if (start_page + number_of_pages > kNumberOfPages) {
+		throw std::invalid_argument("image does not fit in the flash");
+	}
+
+	std::vector<size_t> to_write(number_of_pages);
+	for (size_t i = 0; i < number_of_pages; i++) {
+		to_write[i] = i;
+	}
+
+	std::set<uint8_t> failed;
+	size_t done_bytes = 0;
+	for (int attempt = 0; attempt < kWriteMaxAttempts && !to_write.empty(); attempt++) {
+		failed.clear();
+
+		std::vector<Bytes> commands;
+		for (size_t i : to_write) {
+			size_t offset = i * kPageSize;
+			uint16_t length = uint16_t(std::min<size_t>(kPageSize, image.size() - offset));
+			commands.push_back(writePageCommand(uint8_t(start_page + i), image.data() + offset, length));
+		}
+		commands.push_back(writePageCommand(0, nullptr, 0));
+
+		transactAll(commands, [&](size_t index, const Response &response) {
+			bool is_flush = index == commands.size() - 1;
+			if (!response.ack) {
+				if (!is_flush) {
+					failed.insert(uint8_t(start_page + to_write[index]));
+				}
+				return;
+			}
+			if (response.data.size() == 4 && response.data[2] == 0) {
+				failed.insert(response.data[3]);
+			}
+			if (!is_flush && attempt == 0) {
+				done_bytes += commands[index].size() - 4;
+				if (on_progress) {
+					on_progress(done_bytes);
+				}
+			}
+		});
+
+		to_write.clear();
+		for (uint8_t page : failed) {
+			if (page >= start_page && page < start_page + number_of_pages) {
+				to_write.push_back(page - start_page);
+			}
+		}
+	}
+
+	WriteResult result;
+	result.failed_pages.assign(failed.begin(), failed.end());
+	return result;
+}
+
+WriteResult BootloaderClient::writeImageBulk(uint8_t start_page, const Bytes &image,
+                                             const std::function<void(size_t)> &on_progress)
+{
+	size_t number_of_pages = (image.size() + kPageSize - 1) / kPageSize;
+	if (image.empty() || start_page + number_of_pages > kNumberOfPages) {
+		throw std::invalid_argument("image does not fit in the flash");
+	}
+
+	Bytes command = {kMemWriteBulk, start_page};
+	putLe32(command, uint32_t(image.size()));
+	putLe32(command, crc32Stm32(image.data(), image.size()));
+
+	Response announce = transact(command);
+	if (!announce.ack || announce.data.empty()) {
+		throw std::runtime_error("bootloader refused the bulk write");
+	}
+
+	uint8_t status = streamCredited(image, kPageSize, announce.data[0], [&](size_t done) {
+		if (on_progress) {
+			on_progress(done);
+		}
+	});
+	return readStreamReport(status, start_page, number_of_pages);
+}
+
+WriteResult BootloaderClient::writeImageCompressed(uint8_t start_page, const Bytes &image, const Bytes &compressed,
+                                                   const std::function<void(size_t)> &on_progress)
+{
+	size_t number_of_pages = (image.size() + kPageSize - 1) / kPageSize;
+	if (image.empty() || compressed.empty() || start_page + number_of_pages > kNumberOfPages) {
+		throw std::invalid_argument("image does not fit in the flash");
+	}
+
+	Bytes command = {kMemWriteCompressed, start_page};
+	putLe32(command, uint32_t(image.size()));
+	putLe32(command, uint32_t(compressed.size()));
+	putLe32(command, crc32Stm32(image.data(), image.size()));
+
+	Response announce = transact(command);
+	if (!announce.ack || announce.data.empty()) {
+		throw std::runtime_error("bootloader refused the compressed write");
+	}
+
+	uint8_t status = streamCredited(compressed, kCompressedBlockSize, announce.data[0], [&](size_t done) {
+		if (on_progress) {
+			// report image bytes, assuming an even compression ratio
+			on_progress(size_t(uint64_t(done) * image.size() / compressed.size()));
+		}
+	});
+	return readStreamReport(status, start_page, number_of_pages);
+}
+
+// Sends the stream in blocks, never more than credit_blocks ahead of the
+// credits, and returns the first byte that is not a credit.
+uint8_t BootloaderClient::streamCredited(const Bytes &stream, size_t block_size, size_t credit_blocks,
+                                         const std::function<void(size_t)> &on_credit)
+{
+	size_t number_of_blocks = (stream.size() + block_size - 1) / block_size;
+	size_t sent = 0;
+	size_t credited = 0;
+	uint8_t status = 0;
+	while (true) {
+		while (sent < number_of_blocks && sent - credited < credit_blocks) {
+			size_t offset = sent * block_size;
+			port_.write(stream.data() + offset, std::min(block_size, stream.size() - offset));
+			sent++;
+		}
+
+		if (port_.read(&status, 1, kBulkTimeout) != 1) {
+			throw TimeoutError("stream write stalled");
+		}
+		if (status != kBulkCredit) {
+			return status;
+		}
+		credited++;
+		on_credit(std::min(credited * block_size, stream.size()));
+	}
+}
+
+// Reads the report ending a bulk or compressed write:
+// [ACK][length][status][first failed page], status being the byte already read.
+WriteResult BootloaderClient::readStreamReport(uint8_t status, uint8_t start_page, size_t number_of_pages)
+{
+	uint8_t report[3];
+	if (status != kAck || port_.read(report, 3, kBulkTimeout) != 3 || report[0] != 2) {
+		throw std::runtime_error("invalid stream write report");
+	}
+
+	WriteResult result;
+	if (report[1] != kBulkWriteSuccess) {
+		if (report[2] != kNoFailedPage) {
+			result.failed_pages.push_back(report[2]);
+		} else {
+			// CRC mismatch, no page to blame
+			for (size_t i = 0; i < number_of_pages; i++) {
+				result.failed_pages.push_back(uint8_t(start_page + i));
+			}
+		}
+	}
+	return result;
+}
+
+WriteResult BootloaderClient::fillPages(uint8_t start_page, uint8_t number_of_pages, uint32_t pattern)
+{
+	if (number_of_pages == 0 || start_page + number_of_pages > kNumberOfPages) {
+		throw std::invalid_argument("pages out of the flash");
+	}
+
+	Bytes command = {kFillPages, start_page, number_of_pages};
+	putLe32(command, pattern);
+
+	// [status][first failed page], every page may need an erase
+	Response response = transact(command, kEraseTimeout);
+	WriteResult result;
+	if (!response.ack || response.data.size() != 2) {
+		for (size_t i = 0; i < number_of_pages; i++) {
+			result.failed_pages.push_back(uint8_t(start_page + i));
+		}
+	} else if (response.data[0] != kBulkWriteSuccess) {
+		result.failed_pages.push_back(response.data[1]);
+	}
+	return result;
+}
+
+bool BootloaderClient::beginSession(uint8_t start_page, const Bytes &image)
+{
+	Bytes command = {kBeginSession, start_page};
+	putLe32(command, uint32_t(image.size()));
+	putLe32(command, crc32Stm32(image.data(), image.size()));
+	return transact(command).ack;
+}
+
+WriteResult BootloaderClient::endSession(uint8_t start_page, size_t number_of_pages)
+{
+	// [status][first failed page], the bootloader waits for the page being erased
+	Response response = transact({kEndSession}, kEraseTimeout);
+	WriteResult result;
+	if (!response.ack || response.data.size() != 2 || response.data[0] != kBulkWriteSuccess) {
+		if (response.ack && response.data.size() == 2 && response.data[1] != kNoFailedPage) {
+			result.failed_pages.push_back(response.data[1]);
+		} else {
+			for (size_t i = 0; i < number_of_pages; i++) {
+				result.failed_pages.push_back(uint8_t(start_page + i));
+			}
+		}
+	}
+	return result;
+}
+
+bool BootloaderClient::readMemory(uint32_t address, uint32_t length, Bytes &data,
+                                  const std::function<void(size_t)> &on_progress)
+{
+	std::vector<Bytes> commands;
+	std::vector<uint32_t> chunk_lengths;
+	for (uint32_t offset = 0; offset < length; offset += kMaxResponseLength) {
+		uint32_t chunk = std::min<uint32_t>(kMaxResponseLength, length - offset);
+		Bytes command = {kMemRead};
+		putLe32(command, address + offset);
+		putLe32(command, chunk);
+		commands.push_back(std::move(command));
+		chunk_lengths.push_back(chunk);
+	}
+
+	size_t done_bytes = 0;
+	std::vector<Response> responses = transactAll(commands, [&](size_t, const Response &response) {
+		done_bytes += response.data.size();
+		if (on_progress) {
+			on_progress(done_bytes);
+		}
+	});
+
+	data.clear();
+	data.reserve(length);
+	for (size_t i = 0; i < responses.size(); i++) {
+		if (!responses[i].ack || responses[i].data.size() != chunk_lengths[i]) {
+			return false;
+		}
+		data.insert(data.end(), responses[i].data.begin(), responses[i].data.end());
+	}
+	return true;
+}
+
+uint32_t BootloaderClient::getRangeCrc(uint32_t address, uint32_t length)
+{
+	Bytes command = {kGetCrc, kCrcModeRange};
+	putLe32(command, address);
+	putLe32(command, length);
+	Response response = expect(command, 4);
+	return getLe32(response.data.data());
+}
+
+std::vector<uint32_t> BootloaderClient::getPageCrcs(uint8_t start_page, uint8_t number_of_pages)
+{
+	std::vector<Bytes> commands;
+	for (unsigned offset = 0; offset < number_of_pages; offset += kCrcMaxPages) {
+		uint8_t count = uint8_t(std::min<unsigned>(kCrcMaxPages, number_of_pages - offset));
+		commands.push_back({kGetCrc, kCrcModePages, uint8_t(start_page + offset), count});
+	}
+
+	std::vector<uint32_t> crcs;
+	for (const Response &response : transactAll(commands)) {
+		if (!response.ack) {
+			throw std::runtime_error("bootloader sent nack");
+		}
+		for (size_t i = 0; i + 4 <= response.data.size(); i += 4) {
+			crcs.push_back(getLe32(response.data.data() + i));
+		}
+	}
+	if (crcs.size() != number_of_pages) {
+		throw std::runtime_error("short response from the bootloader");
+	}
+	return crcs;
+}
+
+// Sends one streaming read and collects its chunks into data. The offsets of
+// chunks with a bad CRC are added to bad_chunks, the stream stays in step
+// since every chunk carries its length.
+bool BootloaderClient::streamRange(uint32_t address, uint32_t length, uint8_t *data, bool rle,
+                                   std::vector<uint32_t> &bad_chunks,
+                                   const std::function<void(size_t)> &on_progress)
+{
+	Bytes command = {kMemReadStream};
+	putLe32(command, address);
+	putLe32(command, length);
+	command.push_back(rle ? kReadFlagRle : 0);
+
+	Response response = transact(command);
+	if (!response.ack || response.data.size() != 4 || getLe32(response.data.data()) != length) {
+		return false;
+	}
+
+	Bytes chunk;
+	for (uint32_t offset = 0; offset < length; offset += kReadChunkSize) {
+		uint32_t chunk_length = std::min(kReadChunkSize, length - offset);
+		uint8_t header[2];
+		uint8_t trailer[4];
+
+		if (port_.read(header, 2, kBulkTimeout) != 2) {
+			throw TimeoutError("streaming read stalled");
+		}
+		uint16_t size = uint16_t(header[0] | header[1] << 8);
+		bool encoded = size & kReadChunkRle;
+		size &= uint16_t(~kReadChunkRle);
+		if (size > kReadChunkSize || (!encoded && size != chunk_length)) {
+			throw std::runtime_error("streaming read out of step");
+		}
+
+		chunk.resize(size);
+		if (port_.read(chunk.data(), size, kBulkTimeout) != size || port_.read(trailer, 4, kBulkTimeout) != 4) {
+			throw TimeoutError("streaming read stalled");
+		}
+
+		bool valid = encoded ? rleDecode(chunk, data + offset, chunk_length)
+		                     : (std::copy(chunk.begin(), chunk.end(), data + offset), true);
+		if (!valid || crc32Stm32(data + offset, chunk_length) != getLe32(trailer)) {
+			bad_chunks.push_back(offset);
+		}
+		if (on_progress) {
+			on_progress(offset + chunk_length);
+		}
+	}
+	return true;
+}
+
+bool BootloaderClient::readMemoryStream(uint32_t address, uint32_t length, Bytes &data, bool rle,
+                                        const std::function<void(size_t)> &on_progress)
+{
+	data.assign(length, 0);
+
+	std::vector<uint32_t> bad_chunks;
+	if (!streamRange(address, length, data.data(), rle, bad_chunks, on_progress)) {
+		return false;
+	}
+
+	for (int retry = 0; retry < kReadMaxRetries && !bad_chunks.empty(); retry++) {
+		std::vector<uint32_t> still_bad;
+		for (uint32_t offset : bad_chunks) {
+			std::vector<uint32_t> bad;
+			uint32_t chunk_length = std::min(kReadChunkSize, length - offset);
+			if (!streamRange(address + offset, chunk_length, data.data() + offset, rle, bad, nullptr)) {
+				return false;
+			}
+			if (!bad.empty()) {
+				still_bad.push_back(offset);
+			}
+		}
+		bad_chunks.swap(still_bad);
+	}
+	return bad_chunks.empty();
+}
+
+bool BootloaderClient::jumpToApplication(uint8_t page)
+{
+	// the bootloader answers before jumping
+	return transact({kJumpToMain, page}).ack;
+}
+
+bool BootloaderClient::writeRam(uint32_t address, const Bytes &image,
+                                const std::function<void(size_t)> &on_progress)
+{
+	for (size_t offset = 0; offset < image.size(); offset += kPageSize) {
+		uint16_t length = uint16_t(std::min<size_t>(kPageSize, image.size() - offset));
+		Bytes command = {kRamWrite};
+		putLe32(command, address + uint32_t(offset));
+		putLe16(command, length);
+		command.insert(command.end(), image.begin() + long(offset), image.begin() + long(offset + length));
+
+		// [length copied]
+		Response response = transact(command);
+		if (!response.ack || response.data.size() != 2 || uint16_t(response.data[0] | response.data[1] << 8) != length) {
+			return false;
+		}
+		if (on_progress) {
+			on_progress(offset + length);
+		}
+	}
+	return true;
+}
+
+bool BootloaderClient::executeRam(uint32_t address)
+{
+	Bytes command = {kRamExec};
+	putLe32(command, address);
+	return transact(command).ack;
+}
+
+bool BootloaderClient::setRdpLevel(uint8_t level)
+{
+	// level 0 is written as the 0xA5 key, level 1 as any other value
+	return transact({kChangeRdpLevel, uint8_t(level == 0 ? 0xA5 : 0x00)}).ack;
+}
+
+bool BootloaderClient::setBaudRate(uint32_t baud_rate)
+{
+	Bytes command = {kSetBaud};
+	putLe32(command, baud_rate);
+	if (!transact(command).ack) {
+		return false;
+	}
+
+	uint32_t old_baud_rate = port_.baudRate();
+	port_.setBaudRate(baud_rate);
+	port_.discardInput();
+
+	bool synced = false;
+	auto start = std::chrono::steady_clock::now();
+	while (!synced && std::chrono::steady_clock::now() - start < kBaudSyncTimeout) {
+		uint8_t byte = kBaudSyncByte;
+		port_.write(&byte, 1);
+		synced = port_.read(&byte, 1, kBaudSyncInterval) == 1 && byte == kBaudSyncAck;
+	}
+
+	if (!synced) {
+		port_.setBaudRate(old_baud_rate);
+	}
+	// let the bootloader see the line go quiet, then drop the extra answers
+	std::this_thread::sleep_for(kBaudSyncSettle);
+	port_.discardInput();
+	return synced;
+}
+
+bool BootloaderClient::connect(std::chrono::milliseconds timeout)
+{
+	port_.discardInput();
+
+	bool synced = false;
+	auto start = std::chrono::steady_clock::now();
+	while (!synced && std::chrono::steady_clock::now() - start < timeout) {
+		uint8_t byte = kBaudSyncByte;
+		port_.write(&byte, 1);
+		synced = port_.read(&byte, 1, kConnectInterval) == 1 && byte == kBaudSyncAck;
+	}
+
+	std::this_thread::sleep_for(kBaudSyncSettle);
+	port_.discardInput();
+	return synced;
+}
+
+} // namespace blflash
@@ -0,0 +1,200 @@
+/*
+ * bootloader_client.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_BOOTLOADER_CLIENT_H_
+#define BLFLASH_BOOTLOADER_CLIENT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "image_header.h"
+#include "serial_port.h"
+
+namespace blflash {
+
+using Bytes = std::vector<uint8_t>;
+
+// Command codes, see bootloader.h.
+enum Command : uint8_t {
+	kGetVersion = 0x10,
+	kGetHelp = 0x11,
+	kGetChipId = 0x12,
+	kGetRdpStatus = 0x13,
+	kGoToAddress = 0x14,
+	kFlashErase = 0x15,
+	kMemWrite = 0x16,
+	kMemRead = 0x17,
+	kJumpToMain = 0x18,
+	kChangeRdpLevel = 0x19,
+	kSetBaud = 0x1A,
+	kMemWriteBulk = 0x1B,
+	kGetCrc = 0x1C,
+	kMemReadStream = 0x1D,
+	kMemWriteCompressed = 0x1E,
+	kFillPages = 0x1F,
+	kBeginSession = 0x20,
+	kEndSession = 0x21,
+	kMassErase = 0x22,
+	kGetImageHeader = 0x23,
+	kGetSlot = 0x24,
+	kSetSlot = 0x25,
+	kSwap = 0x26,
+	kRamWrite = 0x27,
+	kRamExec = 0x28,
+};
+
+constexpr uint8_t kAck = 0x01;
+constexpr uint16_t kPageSize = 1024;
+constexpr uint8_t kNumberOfPages = 64;
+// largest response payload, the length is sent in one byte
+constexpr uint16_t kMaxResponseLength = 255;
+// farthest a match of a compressed write may reach back
+constexpr size_t kLzWindowSize = 2048;
+// SRAM window images are loaded to, see app_linker/ram.ld
+constexpr uint32_t kRamImageAddress = 0x20002800;
+constexpr uint32_t kRamImageSize = 0x23C0;
+
+// The bootloader did not answer in time.
+class TimeoutError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+struct Response {
+	bool ack = false;
+	Bytes data;
+};
+
+struct Version {
+	uint8_t vendor_id = 0;
+	uint8_t major = 0;
+	uint8_t minor = 0;
+	uint8_t patch = 0;
+	// 0 when the bootloader only accepts stop-and-wait frames
+	uint8_t window_size = 0;
+};
+
+// Application slot layout of the bootloader.
+struct SlotInfo {
+	uint8_t active = 0;
+	// first page of each slot, the page of its image header
+	std::vector<uint8_t> first_pages;
+	uint8_t pages = 0;
+};
+
+// Outcome of writing an image, pages are flash page numbers.
+struct WriteResult {
+	std::vector<uint8_t> failed_pages;
+	bool ok() const { return failed_pages.empty(); }
+};
+
+// Speaks the bootloader frame protocol over a serial port.
+//
+// Legacy frames are [length][command][arguments][CRC] and are answered with
+// [ACK/NACK][data length][data]. Windowed frames carry a sequence number and
+// up to window_size of them are kept in flight, see the README.
+class BootloaderClient {
+public:
+	using ResponseCallback = std::function<void(size_t index, const Response &response)>;
+
+	explicit BootloaderClient(SerialPort &port);
+
+	// Sends one command with stop-and-wait framing.
+	Response transact(const Bytes &command,
+	                  std::chrono::milliseconds timeout = std::chrono::milliseconds(2000));
+
+	// Sends a batch of commands, windowed when enabled, and returns their
+	// responses in order. A command NACKed or lost too often gets ack = false.
+	std::vector<Response> transactAll(const std::vector<Bytes> &commands,
+	                                  const ResponseCallback &on_response = nullptr);
+
+	// Enables windowed frames, 0 goes back to stop-and-wait.
+	void setWindowSize(uint8_t window_size) { window_size_ = window_size; }
+	uint8_t windowSize() const { return window_size_; }
+
+	Version getVersion();
+	Bytes getHelp();
+	uint16_t getChipId();
+	uint8_t getRdpLevel();
+	// Image header of an application slot.
+	ImageHeader getImageHeader(uint8_t slot);
+	SlotInfo getSlots();
+	// Selects the slot started at reset, NACKed unless it holds a valid image.
+	bool setActiveSlot(uint8_t slot);
+	// Swaps the image staged in slot B, linked for slot A, into slot A. Slot B
+	// keeps the previous image, NACKed unless the staged image is valid.
+	bool swapImages(uint8_t &swapped_pages);
+	bool goToAddress(uint32_t address);
+	bool eraseFlash(uint8_t start_page, uint8_t number_of_pages);
+	// Erases the whole flash but the bootloader, the pages from
+	// first_free_page on are blank afterwards.
+	bool massErase(uint8_t &first_free_page);
+	WriteResult writeImage(uint8_t start_page, const Bytes &image,
+	                       const std::function<void(size_t)> &on_progress = nullptr);
+	// Streams the whole image after a single command, the bootloader paces
+	// the stream with one credit byte per page taken in.
+	WriteResult writeImageBulk(uint8_t start_page, const Bytes &image,
+	                           const std::function<void(size_t)> &on_progress = nullptr);
+	// Streams the image LZ4 compressed after a single command, paced like
+	// writeImageBulk with one credit per 1 KB of compressed data.
+	WriteResult writeImageCompressed(uint8_t start_page, const Bytes &image, const Bytes &compressed,
+	                                 const std::function<void(size_t)> &on_progress = nullptr);
+	// Fills whole pages with a repeated 32-bit pattern in one frame.
+	WriteResult fillPages(uint8_t start_page, uint8_t number_of_pages, uint32_t pattern);
+	// Announces an image written from start_page, the bootloader erases its
+	// pages in the background while the writes arrive.
+	bool beginSession(uint8_t start_page, const Bytes &image);
+	// Ends the session, the bootloader checks the image CRC.
+	WriteResult endSession(uint8_t start_page, size_t number_of_pages);
+	bool readMemory(uint32_t address, uint32_t length, Bytes &data,
+	                const std::function<void(size_t)> &on_progress = nullptr);
+	// Reads a range of any length with one command, optionally run-length
+	// encoded. Chunks failing their CRC are read again.
+	bool readMemoryStream(uint32_t address, uint32_t length, Bytes &data, bool rle,
+	                      const std::function<void(size_t)> &on_progress = nullptr);
+	// CRC-32 of a memory range, computed on the device.
+	uint32_t getRangeCrc(uint32_t address, uint32_t length);
+	// CRC-32 of each flash page in [start_page, start_page + number_of_pages).
+	std::vector<uint32_t> getPageCrcs(uint8_t start_page, uint8_t number_of_pages);
+	bool jumpToApplication(uint8_t page);
+	// Copies an image to the SRAM image window, no flash is written.
+	bool writeRam(uint32_t address, const Bytes &image,
+	              const std::function<void(size_t)> &on_progress = nullptr);
+	// Starts the image whose vector table is at address, the bootloader
+	// answers before it jumps.
+	bool executeRam(uint32_t address);
+	bool setRdpLevel(uint8_t level);
+	// Switches both sides to a new rate, stays on the old one if the sync
+	// exchange fails.
+	bool setBaudRate(uint32_t baud_rate);
+	// Sends sync bytes until the bootloader answers, to catch its autoboot
+	// window while the board comes out of reset.
+	bool connect(std::chrono::milliseconds timeout);
+
+private:
+	Response readResponse(bool windowed, uint8_t sequence, std::chrono::milliseconds timeout);
+	void sendFrame(const Bytes &command, bool windowed, uint8_t sequence);
+	std::vector<Response> transactWindowed(const std::vector<Bytes> &commands,
+	                                       const ResponseCallback &on_response);
+	Response expect(const Bytes &command, size_t minimum_length);
+	uint8_t streamCredited(const Bytes &stream, size_t block_size, size_t credit_blocks,
+	                       const std::function<void(size_t)> &on_credit);
+	WriteResult readStreamReport(uint8_t status, uint8_t start_page, size_t number_of_pages);
+	bool streamRange(uint32_t address, uint32_t length, uint8_t *data, bool rle,
+	                 std::vector<uint32_t> &bad_chunks, const std::function<void(size_t)> &on_progress);
+
+	SerialPort &port_;
+	uint8_t window_size_ = 0;
+};
+
+} // namespace blflash
+
+#endif /* BLFLASH_BOOTLOADER_CLIENT_H_ */
@@ -0,0 +1,67 @@
+/*
+ * crc32.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "crc32.h"
+
+#include <array>
+
+namespace blflash {
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x04C11DB7;
+
+// crc_table[i] is the CRC register after shifting the byte i out of its top
+constexpr std::array<uint32_t, 256> makeTable()
+{
+	std::array<uint32_t, 256> table{};
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i << 24;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ kPolynomial : (crc << 1);
+		}
+		table[i] = crc;
+	}
+	return table;
+}
+
+constexpr std::array<uint32_t, 256> kTable = makeTable();
+
+uint32_t feedWord(uint32_t crc, uint32_t word)
+{
+	crc ^= word;
+	for (int i = 0; i < 4; i++) {
+		crc = (crc << 8) ^ kTable[crc >> 24];
+	}
+	return crc;
+}
+
+} // namespace
+
+uint32_t crc32Stm32(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	size_t i = 0;
+
+	for (; i + 4 <= length; i += 4) {
+		uint32_t word = uint32_t(data[i]) | uint32_t(data[i + 1]) << 8 |
+		                uint32_t(data[i + 2]) << 16 | uint32_t(data[i + 3]) << 24;
+		crc = feedWord(crc, word);
+	}
+
+	if (i < length) {
+		uint32_t word = 0;
+		for (size_t shift = 0; i < length; i++, shift += 8) {
+			word |= uint32_t(data[i]) << shift;
+		}
+		crc = feedWord(crc, word);
+	}
+
+	return crc;
+}
+
+} // namespace blflash
@@ -0,0 +1,23 @@
+/*
+ * crc32.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_CRC32_H_
+#define BLFLASH_CRC32_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blflash {
+
+// CRC-32 as computed by the STM32 CRC unit: polynomial 0x04C11DB7, initial
+// value 0xFFFFFFFF, no reflection, no final XOR. The buffer is processed as
+// little-endian 32-bit words, a last partial word is zero-padded.
+uint32_t crc32Stm32(const uint8_t *data, size_t length);
+
+} // namespace blflash
+
+#endif /* BLFLASH_CRC32_H_ */
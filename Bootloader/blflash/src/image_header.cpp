@@ -0,0 +1,68 @@
+/*
+ * image_header.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "image_header.h"
+
+#include "crc32.h"
+
+namespace blflash {
+
+namespace {
+
+// the header CRC covers everything up to the header CRC itself
+constexpr size_t kHeaderCrcOffset = 24;
+
+void putLe32(std::vector<uint8_t> &out, uint32_t value)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		out.push_back(uint8_t(value >> shift));
+	}
+}
+
+uint32_t getLe32(const uint8_t *data)
+{
+	return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+}
+
+} // namespace
+
+std::vector<uint8_t> makeImageHeader(uint32_t header_address, const std::vector<uint8_t> &image,
+                                     uint8_t major, uint8_t minor, uint16_t patch, uint32_t build_id)
+{
+	std::vector<uint8_t> header;
+	putLe32(header, kImageMagic);
+	putLe32(header, header_address + uint32_t(kImageHeaderSize));
+	putLe32(header, uint32_t(image.size()));
+	putLe32(header, crc32Stm32(image.data(), image.size()));
+	header.push_back(major);
+	header.push_back(minor);
+	header.push_back(uint8_t(patch));
+	header.push_back(uint8_t(patch >> 8));
+	putLe32(header, build_id);
+	putLe32(header, crc32Stm32(header.data(), kHeaderCrcOffset));
+	// the validity marker stays erased, the bootloader programs it
+	header.resize(kImageHeaderSize, 0xFF);
+	return header;
+}
+
+ImageHeader parseImageHeader(const uint8_t *data)
+{
+	ImageHeader header;
+	header.magic = getLe32(data);
+	header.load_address = getLe32(data + 4);
+	header.image_length = getLe32(data + 8);
+	header.image_crc = getLe32(data + 12);
+	header.version_major = data[16];
+	header.version_minor = data[17];
+	header.version_patch = uint16_t(data[18] | data[19] << 8);
+	header.build_id = getLe32(data + 20);
+	header.header_crc = getLe32(data + 24);
+	header.valid_marker = getLe32(data + 28);
+	return header;
+}
+
+} // namespace blflash
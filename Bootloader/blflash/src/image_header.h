@@ -0,0 +1,50 @@
+/*
+ * image_header.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_IMAGE_HEADER_H_
+#define BLFLASH_IMAGE_HEADER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blflash {
+
+// flash reserved for the header, the vector table of the image follows it
+constexpr size_t kImageHeaderSize = 0x200;
+// bytes of the header fields as the bootloader stores them
+constexpr size_t kImageHeaderLength = 32;
+constexpr uint32_t kImageMagic = 0x474D4942;
+// marker the bootloader programs once the image passed its CRC check
+constexpr uint32_t kImageValid = 0x444C4156;
+
+struct ImageHeader {
+	uint32_t magic = 0;
+	uint32_t load_address = 0;
+	uint32_t image_length = 0;
+	uint32_t image_crc = 0;
+	uint8_t version_major = 0;
+	uint8_t version_minor = 0;
+	uint16_t version_patch = 0;
+	uint32_t build_id = 0;
+	uint32_t header_crc = 0;
+	uint32_t valid_marker = 0xFFFFFFFF;
+	// set by BootloaderClient::getImageHeader: the header and the image passed the check
+	bool valid = false;
+};
+
+// Header region for an image linked to run at header_address + kImageHeaderSize:
+// the fields with their CRCs, padded with the erased value to kImageHeaderSize.
+std::vector<uint8_t> makeImageHeader(uint32_t header_address, const std::vector<uint8_t> &image,
+                                     uint8_t major, uint8_t minor, uint16_t patch, uint32_t build_id);
+
+// Decodes the first kImageHeaderLength bytes of data.
+ImageHeader parseImageHeader(const uint8_t *data);
+
+} // namespace blflash
+
+#endif /* BLFLASH_IMAGE_HEADER_H_ */
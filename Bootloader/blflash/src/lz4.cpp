@@ -0,0 +1,115 @@
+/*
+ * lz4.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace blflash {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLengthExtended = 15;
+// the last match has to start this far from the end, the tail is literals
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kHashBits = 14;
+// candidates looked at per position, more finds longer matches more slowly
+constexpr int kMaxChain = 256;
+constexpr uint32_t kNoPosition = 0xFFFFFFFF;
+
+uint32_t hash4(const uint8_t *p)
+{
+	uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+void putLength(std::vector<uint8_t> &out, size_t length)
+{
+	while (length >= 255) {
+		out.push_back(255);
+		length -= 255;
+	}
+	out.push_back(uint8_t(length));
+}
+
+void putSequence(std::vector<uint8_t> &out, const uint8_t *literals, size_t literal_length, size_t offset,
+                 size_t match_length)
+{
+	size_t match_code = match_length ? match_length - kMinMatch : 0;
+	uint8_t token = uint8_t((std::min(literal_length, kLengthExtended) << 4) | std::min(match_code, kLengthExtended));
+	out.push_back(token);
+	if (literal_length >= kLengthExtended) {
+		putLength(out, literal_length - kLengthExtended);
+	}
+	out.insert(out.end(), literals, literals + literal_length);
+
+	if (match_length) {
+		out.push_back(uint8_t(offset));
+		out.push_back(uint8_t(offset >> 8));
+		if (match_code >= kLengthExtended) {
+			putLength(out, match_code - kLengthExtended);
+		}
+	}
+}
+
+} // namespace
+
+std::vector<uint8_t> lz4Compress(const std::vector<uint8_t> &data, size_t window_size)
+{
+	std::vector<uint8_t> out;
+	std::vector<uint32_t> head(size_t(1) << kHashBits, kNoPosition);
+	std::vector<uint32_t> previous(data.size(), kNoPosition);
+	const uint8_t *base = data.data();
+	size_t match_limit = data.size() > kLastLiterals ? data.size() - kLastLiterals : 0;
+
+	auto insert = [&](size_t position) {
+		uint32_t hash = hash4(base + position);
+		previous[position] = head[hash];
+		head[hash] = uint32_t(position);
+	};
+
+	size_t position = 0;
+	size_t literal_start = 0;
+	while (position + kMinMatch <= match_limit) {
+		size_t best_length = 0;
+		size_t best_offset = 0;
+		uint32_t candidate = head[hash4(base + position)];
+		for (int chain = 0; chain < kMaxChain && candidate != kNoPosition && position - candidate <= window_size;
+		     chain++, candidate = previous[candidate]) {
+			size_t length = 0;
+			while (position + length < match_limit && base[candidate + length] == base[position + length]) {
+				length++;
+			}
+			if (length > best_length) {
+				best_length = length;
+				best_offset = position - candidate;
+			}
+		}
+
+		if (best_length < kMinMatch) {
+			insert(position);
+			position++;
+			continue;
+		}
+
+		putSequence(out, base + literal_start, position - literal_start, best_offset, best_length);
+		for (size_t end = position + best_length; position < end; position++) {
+			if (position + kMinMatch <= data.size()) {
+				insert(position);
+			}
+		}
+		literal_start = position;
+	}
+
+	putSequence(out, base + literal_start, data.size() - literal_start, 0, 0);
+	return out;
+}
+
+} // namespace blflash
@@ -0,0 +1,24 @@
+/*
+ * lz4.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_LZ4_H_
+#define BLFLASH_LZ4_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blflash {
+
+// Compresses data into an LZ4 block. No match reaches back more than
+// window_size bytes, so the bootloader decompresses it through a window of
+// that size, and the block ends with literals like any LZ4 block.
+std::vector<uint8_t> lz4Compress(const std::vector<uint8_t> &data, size_t window_size);
+
+} // namespace blflash
+
+#endif /* BLFLASH_LZ4_H_ */
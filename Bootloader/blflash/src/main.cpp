@@ -0,0 +1,725 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  blflash: command line host for the UART bootloader.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bootloader_client.h"
+#include "crc32.h"
+#include "image_header.h"
+#include "lz4.h"
+#include "progress.h"
+#include "serial_port.h"
+
+using namespace blflash;
+
+namespace {
+
+const char kUsage[] =
+	"usage: blflash [options] <command> [arguments]\n"
+	"\n"
+	"options:\n"
+	"  -p, --port <device>     serial port (default /dev/ttyUSB0)\n"
+	"  -b, --baud <rate>       baud rate the bootloader is listening at (default 115200)\n"
+	"  -s, --speed <rate>      switch to this baud rate before running the command\n"
+	"  -c, --connect <ms>      keep sending sync bytes for up to <ms> while the board is reset,\n"
+	"                          so the bootloader stays instead of starting the application\n"
+	"      --no-window         use stop-and-wait frames even if windowed frames are supported\n"
+	"  -q, --quiet             no progress output\n"
+	"\n"
+	"commands:\n"
+	"  version                             bootloader vendor id and version\n"
+	"  help                                supported command codes\n"
+	"  chip-id                             MCU device id\n"
+	"  rdp                                 read protection level\n"
+	"  slots                               active slot and the image of each slot\n"
+	"  image-info [slot]                   image header of a slot (default the active one)\n"
+	"  set-slot <slot>                     start the application from <slot> at reset\n"
+	"  swap                                swap the images of slot A and slot B\n"
+	"  go <address>                        call the code at <address>\n"
+	"  erase <page> <count>                erase <count> pages from <page>\n"
+	"  mass-erase                          erase all pages after the bootloader\n"
+	"  write <file> --page <n> [--verify] [--full] [--mass-erase]\n"
+	"                                      write a binary image from page <n>, skipping the\n"
+	"                                      pages that already match unless --full is given,\n"
+	"                                      --mass-erase clears the flash first\n"
+	"         [--header <major.minor.patch> [--build-id <n>]]\n"
+	"                                      prepend an image header, the image has to be\n"
+	"                                      linked 0x200 bytes after the start of page <n>\n"
+	"  write <file> --slot <slot|inactive> --header <major.minor.patch> [--activate] ...\n"
+	"                                      write to the first page of a slot, --activate\n"
+	"                                      selects the slot once the image is written\n"
+	"  write <file> --swap --header <major.minor.patch> ...\n"
+	"                                      stage an image linked for slot A in slot B,\n"
+	"                                      then swap it into slot A\n"
+	"  read <address> <length> [-o <file>] read memory, hex dump unless -o is given\n"
+	"  crc <address> <length>              CRC-32 of a memory range\n"
+	"  crc-pages <page> <count>            CRC-32 of each flash page\n"
+	"  jump <page>                         start the application at <page>\n"
+	"  run <file> [address]                load an image linked for the SRAM (app_linker/ram.ld)\n"
+	"                                      and start it, nothing is written to the flash\n"
+	"  set-rdp <0|1>                       change the read protection level\n"
+	"  set-baud <rate>                     switch the link to <rate> and stay there\n"
+	"\n"
+	"numbers may be given in decimal or with a 0x prefix, slots as a or b.\n";
+
+struct Options {
+	std::string port = "/dev/ttyUSB0";
+	uint32_t baud_rate = 115200;
+	uint32_t speed = 0;
+	uint32_t connect = 0;
+	bool window = true;
+	bool quiet = false;
+	bool verify = false;
+	bool full = false;
+	bool mass_erase = false;
+	std::string header_version;
+	uint32_t build_id = 0;
+	std::string slot;
+	bool activate = false;
+	bool swap = false;
+	long page = -1;
+	std::string output;
+	std::vector<std::string> arguments;
+};
+
+class UsageError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+uint32_t parseNumber(const std::string &text, uint32_t max = 0xFFFFFFFF)
+{
+	size_t end = 0;
+	unsigned long value = 0;
+	try {
+		value = std::stoul(text, &end, 0);
+	} catch (const std::exception &) {
+		end = 0;
+	}
+	if (end == 0 || end != text.size() || value > max) {
+		throw UsageError("invalid number '" + text + "'");
+	}
+	return uint32_t(value);
+}
+
+// major.minor.patch
+void parseVersion(const std::string &text, uint8_t &major, uint8_t &minor, uint16_t &patch)
+{
+	size_t first_dot = text.find('.');
+	size_t second_dot = first_dot == std::string::npos ? first_dot : text.find('.', first_dot + 1);
+	if (second_dot == std::string::npos) {
+		throw UsageError("invalid version '" + text + "', expected major.minor.patch");
+	}
+	major = uint8_t(parseNumber(text.substr(0, first_dot), 0xFF));
+	minor = uint8_t(parseNumber(text.substr(first_dot + 1, second_dot - first_dot - 1), 0xFF));
+	patch = uint16_t(parseNumber(text.substr(second_dot + 1), 0xFFFF));
+}
+
+uint8_t parseSlot(const std::string &text)
+{
+	if (text == "a" || text == "A") {
+		return 0;
+	}
+	if (text == "b" || text == "B") {
+		return 1;
+	}
+	return uint8_t(parseNumber(text, 0xFF));
+}
+
+char slotName(uint8_t slot)
+{
+	return char('A' + slot);
+}
+
+Options parseArguments(int argc, char **argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto value = [&]() -> std::string {
+			if (i + 1 >= argc) {
+				throw UsageError("missing value for " + arg);
+			}
+			return argv[++i];
+		};
+
+		if (arg == "-p" || arg == "--port") {
+			options.port = value();
+		} else if (arg == "-b" || arg == "--baud") {
+			options.baud_rate = parseNumber(value());
+		} else if (arg == "-s" || arg == "--speed") {
+			options.speed = parseNumber(value());
+		} else if (arg == "-c" || arg == "--connect") {
+			options.connect = parseNumber(value());
+		} else if (arg == "--no-window") {
+			options.window = false;
+		} else if (arg == "-q" || arg == "--quiet") {
+			options.quiet = true;
+		} else if (arg == "--verify") {
+			options.verify = true;
+		} else if (arg == "--full") {
+			options.full = true;
+		} else if (arg == "--mass-erase") {
+			options.mass_erase = true;
+		} else if (arg == "--header") {
+			options.header_version = value();
+		} else if (arg == "--build-id") {
+			options.build_id = parseNumber(value());
+		} else if (arg == "--slot") {
+			options.slot = value();
+		} else if (arg == "--activate") {
+			options.activate = true;
+		} else if (arg == "--swap") {
+			options.swap = true;
+		} else if (arg == "--page") {
+			options.page = parseNumber(value(), kNumberOfPages - 1);
+		} else if (arg == "-o" || arg == "--output") {
+			options.output = value();
+		} else if (arg == "-h" || arg == "--help") {
+			std::fputs(kUsage, stdout);
+			std::exit(EXIT_SUCCESS);
+		} else if (arg.size() > 1 && arg[0] == '-') {
+			throw UsageError("unknown option " + arg);
+		} else {
+			options.arguments.push_back(arg);
+		}
+	}
+
+	if (options.arguments.empty()) {
+		throw UsageError("no command given");
+	}
+	return options;
+}
+
+void expectArguments(const Options &options, size_t count)
+{
+	if (options.arguments.size() != count + 1) {
+		throw UsageError("wrong number of arguments for " + options.arguments[0]);
+	}
+}
+
+void check(bool ack, const std::string &what)
+{
+	if (!ack) {
+		throw std::runtime_error(what + ": bootloader sent nack");
+	}
+}
+
+Bytes readFile(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	return Bytes(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string &path, const Bytes &data)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+	if (!file) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+void hexDump(uint32_t address, const Bytes &data)
+{
+	for (size_t offset = 0; offset < data.size(); offset += 16) {
+		std::printf("%08x:", unsigned(address + offset));
+		for (size_t i = offset; i < offset + 16 && i < data.size(); i++) {
+			std::printf(" %02x", data[i]);
+		}
+		std::printf("\n");
+	}
+}
+
+bool supports(const Bytes &commands, uint8_t code)
+{
+	return std::find(commands.begin(), commands.end(), code) != commands.end();
+}
+
+// Reads with one streaming command when the bootloader has it, 255 bytes
+// per command otherwise.
+bool readRange(BootloaderClient &client, const Bytes &commands, uint32_t address, uint32_t length, Bytes &data,
+               const std::function<void(size_t)> &on_progress)
+{
+	if (supports(commands, kMemReadStream)) {
+		return client.readMemoryStream(address, length, data, true, on_progress);
+	}
+	return client.readMemory(address, length, data, on_progress);
+}
+
+// Contiguous pages of an image, as page indices into the image.
+struct PageRun {
+	size_t first;
+	size_t count;
+	// every page of the run repeats pattern, it is filled instead of sent
+	bool fill = false;
+	uint32_t pattern = 0;
+};
+
+// Page of the image as it ends up in the flash: the bootloader pads the last
+// page with the erased value.
+Bytes paddedPage(const Bytes &image, size_t index)
+{
+	Bytes padded(kPageSize, 0xFF);
+	size_t length = std::min<size_t>(kPageSize, image.size() - index * kPageSize);
+	std::copy_n(image.begin() + long(index * kPageSize), length, padded.begin());
+	return padded;
+}
+
+bool isFilledWith(const Bytes &page, uint32_t &pattern)
+{
+	std::memcpy(&pattern, page.data(), sizeof(pattern));
+	for (size_t offset = sizeof(pattern); offset < page.size(); offset += sizeof(pattern)) {
+		if (std::memcmp(page.data() + offset, &pattern, sizeof(pattern)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Groups the pages of the image into runs, leaving out the pages whose flash
+// CRC already matches when skip_unchanged is set.
+std::vector<PageRun> pagesToWrite(BootloaderClient &client, uint8_t page, const Bytes &image, bool skip_unchanged)
+{
+	size_t number_of_pages = (image.size() + kPageSize - 1) / kPageSize;
+	std::vector<bool> changed(number_of_pages, true);
+
+	if (skip_unchanged) {
+		std::vector<uint32_t> flash_crcs = client.getPageCrcs(page, uint8_t(number_of_pages));
+		for (size_t i = 0; i < number_of_pages; i++) {
+			Bytes padded = paddedPage(image, i);
+			changed[i] = crc32Stm32(padded.data(), padded.size()) != flash_crcs[i];
+		}
+	}
+
+	std::vector<PageRun> runs;
+	for (size_t i = 0; i < number_of_pages; i++) {
+		if (!changed[i]) {
+			continue;
+		}
+		if (!runs.empty() && runs.back().first + runs.back().count == i) {
+			runs.back().count++;
+		} else {
+			runs.push_back({i, 1});
+		}
+	}
+	return runs;
+}
+
+// Splits the runs into runs of pages repeating one 32-bit pattern, to be
+// filled by the bootloader, and runs of pages to send.
+std::vector<PageRun> splitFillRuns(const Bytes &image, const std::vector<PageRun> &runs)
+{
+	std::vector<PageRun> split;
+	for (const PageRun &run : runs) {
+		for (size_t i = run.first; i < run.first + run.count; i++) {
+			PageRun page_run = {i, 1};
+			page_run.fill = isFilledWith(paddedPage(image, i), page_run.pattern);
+
+			if (!split.empty()) {
+				PageRun &last = split.back();
+				if (last.first + last.count == i && last.fill == page_run.fill &&
+				    (!last.fill || last.pattern == page_run.pattern)) {
+					last.count++;
+					continue;
+				}
+			}
+			split.push_back(page_run);
+		}
+	}
+	return split;
+}
+
+int commandWrite(BootloaderClient &client, const Options &options)
+{
+	expectArguments(options, 1);
+	if (options.page < 0 && options.slot.empty() && !options.swap) {
+		throw UsageError("write needs --page, --slot or --swap");
+	}
+	if (options.swap && (options.page >= 0 || !options.slot.empty())) {
+		throw UsageError("--swap stages the image in slot B, it takes no --page or --slot");
+	}
+	if ((!options.slot.empty() || options.swap) && options.header_version.empty()) {
+		throw UsageError("a slot image needs --header");
+	}
+	if (options.activate && options.slot.empty()) {
+		throw UsageError("--activate needs --slot");
+	}
+
+	Bytes image = readFile(options.arguments[1]);
+	if (image.empty()) {
+		throw std::runtime_error(options.arguments[1] + " is empty");
+	}
+	uint8_t page = uint8_t(options.page);
+	uint8_t slot = 0;
+	// where the image header is once the image runs, its page unless the image is swapped
+	uint32_t header_address = 0x08000000 + uint32_t(page) * kPageSize;
+	if (options.swap) {
+		// linked for slot A, which keeps its last page free to move the images through
+		SlotInfo slots = client.getSlots();
+		if (kImageHeaderSize + image.size() > size_t(slots.pages - 1) * kPageSize) {
+			throw std::runtime_error(options.arguments[1] + " is too large to be swapped");
+		}
+		page = slots.first_pages[1];
+		header_address = 0x08000000 + uint32_t(slots.first_pages[0]) * kPageSize;
+	} else if (!options.slot.empty()) {
+		SlotInfo slots = client.getSlots();
+		slot = options.slot == "inactive" ? uint8_t(1 - slots.active) : parseSlot(options.slot);
+		if (slot >= slots.first_pages.size()) {
+			throw UsageError("no slot " + options.slot);
+		}
+		if (kImageHeaderSize + image.size() > size_t(slots.pages) * kPageSize) {
+			throw std::runtime_error(options.arguments[1] + " does not fit in slot " + slotName(slot));
+		}
+		page = slots.first_pages[slot];
+		header_address = 0x08000000 + uint32_t(page) * kPageSize;
+	}
+	if (!options.header_version.empty()) {
+		uint8_t major = 0;
+		uint8_t minor = 0;
+		uint16_t patch = 0;
+		parseVersion(options.header_version, major, minor, patch);
+		Bytes header = makeImageHeader(header_address, image, major, minor, patch, options.build_id);
+		image.insert(image.begin(), header.begin(), header.end());
+	}
+	if (page + (image.size() + kPageSize - 1) / kPageSize > kNumberOfPages) {
+		throw std::runtime_error(options.arguments[1] + " does not fit in the flash from page " + std::to_string(page));
+	}
+	uint32_t address = 0x08000000 + uint32_t(page) * kPageSize;
+
+	Bytes commands = client.getHelp();
+	bool bulk = supports(commands, kMemWriteBulk);
+	bool compress = supports(commands, kMemWriteCompressed);
+	bool fill = supports(commands, kFillPages);
+	bool session = supports(commands, kBeginSession);
+	bool crc = supports(commands, kGetCrc);
+
+	if (options.mass_erase) {
+		// everything but the bootloader is blank afterwards, no page needs to be compared
+		uint8_t first_free_page = 0;
+		if (!supports(commands, kMassErase)) {
+			throw std::runtime_error("the bootloader does not support mass erase");
+		}
+		check(client.massErase(first_free_page), "mass erase");
+		if (page < first_free_page) {
+			throw std::runtime_error("page " + std::to_string(page) + " is in the bootloader, the first free page is " +
+			                         std::to_string(first_free_page));
+		}
+	}
+
+	std::vector<PageRun> runs = pagesToWrite(client, page, image, crc && !options.full && !options.mass_erase);
+	if (fill) {
+		runs = splitFillRuns(image, runs);
+	}
+	if (options.mass_erase) {
+		// blank pages are already in place
+		runs.erase(std::remove_if(runs.begin(), runs.end(),
+		                          [](const PageRun &run) { return run.fill && run.pattern == 0xFFFFFFFF; }),
+		           runs.end());
+	}
+	std::vector<Bytes> parts;
+	size_t total_bytes = 0;
+	for (const PageRun &run : runs) {
+		size_t offset = run.first * kPageSize;
+		size_t length = std::min(run.count * kPageSize, image.size() - offset);
+		parts.emplace_back(image.begin() + long(offset), image.begin() + long(offset + length));
+		total_bytes += length;
+	}
+
+	Progress write_progress("write ", total_bytes, options.quiet);
+	WriteResult result;
+	size_t written_bytes = 0;
+	for (size_t i = 0; i < runs.size() && result.ok(); i++) {
+		uint8_t run_page = uint8_t(page + runs[i].first);
+		auto on_progress = [&](size_t done) { write_progress.update(written_bytes + done); };
+		Bytes compressed = compress && !runs[i].fill ? lz4Compress(parts[i], kLzWindowSize) : Bytes();
+		bool streamed = true;
+		// the bootloader erases the pages of the run while they are on the wire
+		bool in_session = session && !runs[i].fill && client.beginSession(run_page, parts[i]);
+
+		if (runs[i].fill) {
+			result = client.fillPages(run_page, uint8_t(runs[i].count), runs[i].pattern);
+			on_progress(parts[i].size());
+		} else if (!compressed.empty() && compressed.size() < parts[i].size()) {
+			result = client.writeImageCompressed(run_page, parts[i], compressed, on_progress);
+		} else if (bulk) {
+			result = client.writeImageBulk(run_page, parts[i], on_progress);
+		} else {
+			result = client.writeImage(run_page, parts[i], on_progress);
+			streamed = false;
+		}
+
+		if (streamed && !result.ok()) {
+			// write the pages from the first failed one again, frame by frame
+			uint8_t failed = result.failed_pages.front();
+			Bytes rest(parts[i].begin() + long(size_t(failed - run_page) * kPageSize), parts[i].end());
+			std::fprintf(stderr, "%s failed at page %u, retrying page by page\n",
+			             runs[i].fill ? "fill" : "stream write", failed);
+			result = client.writeImage(failed, rest);
+		}
+
+		if (in_session) {
+			WriteResult session_result = client.endSession(run_page, runs[i].count);
+			if (result.ok()) {
+				result = session_result;
+			}
+		}
+		written_bytes += parts[i].size();
+	}
+	write_progress.finish();
+
+	if (!result.ok()) {
+		std::fprintf(stderr, "writing failed for pages");
+		for (uint8_t failed : result.failed_pages) {
+			std::fprintf(stderr, " %u", failed);
+		}
+		std::fprintf(stderr, "\n");
+		return EXIT_FAILURE;
+	}
+
+	if (options.verify && crc) {
+		if (client.getRangeCrc(address, uint32_t(image.size())) != crc32Stm32(image.data(), image.size())) {
+			std::fprintf(stderr, "verify failed: flash CRC does not match the image\n");
+			return EXIT_FAILURE;
+		}
+	} else if (options.verify) {
+		Bytes flash;
+		Progress verify_progress("verify", image.size(), options.quiet);
+		bool read_ok = readRange(client, commands, address, uint32_t(image.size()), flash,
+		                         [&](size_t done) { verify_progress.update(done); });
+		verify_progress.finish();
+		check(read_ok, "verify");
+
+		for (size_t i = 0; i < image.size(); i++) {
+			if (flash[i] != image[i]) {
+				std::fprintf(stderr, "verify failed at 0x%08x: wrote %02x, read %02x\n",
+				             unsigned(address + i), image[i], flash[i]);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	std::printf("wrote %zu of %zu bytes from page %u%s\n", total_bytes, image.size(), page,
+	            options.verify ? ", verified" : "");
+
+	if (options.activate) {
+		check(client.setActiveSlot(slot), "activate");
+		std::printf("slot %c is active\n", slotName(slot));
+	}
+	if (options.swap) {
+		uint8_t swapped_pages = 0;
+		check(client.swapImages(swapped_pages), "swap");
+		std::printf("swapped %u pages into slot A\n", swapped_pages);
+	}
+	return EXIT_SUCCESS;
+}
+
+int commandRead(BootloaderClient &client, const Options &options)
+{
+	expectArguments(options, 2);
+	uint32_t address = parseNumber(options.arguments[1]);
+	uint32_t length = parseNumber(options.arguments[2]);
+
+	Bytes data;
+	Progress progress("read  ", length, options.quiet || options.output.empty());
+	check(readRange(client, client.getHelp(), address, length, data, [&](size_t done) { progress.update(done); }),
+	      "read");
+	progress.finish();
+
+	if (options.output.empty()) {
+		hexDump(address, data);
+	} else {
+		writeFile(options.output, data);
+	}
+	return EXIT_SUCCESS;
+}
+
+int commandRun(BootloaderClient &client, const Options &options)
+{
+	if (options.arguments.size() != 2) {
+		expectArguments(options, 2);
+	}
+	uint32_t address = options.arguments.size() == 3 ? parseNumber(options.arguments[2]) : kRamImageAddress;
+	Bytes image = readFile(options.arguments[1]);
+	if (image.empty()) {
+		throw std::runtime_error(options.arguments[1] + " is empty");
+	}
+	if (address < kRamImageAddress || image.size() > kRamImageSize - (address - kRamImageAddress)) {
+		throw std::runtime_error(options.arguments[1] + " does not fit in the SRAM image window");
+	}
+
+	Progress progress("load  ", image.size(), options.quiet);
+	check(client.writeRam(address, image, [&](size_t done) { progress.update(done); }), "load");
+	progress.finish();
+	if (client.getRangeCrc(address, uint32_t(image.size())) != crc32Stm32(image.data(), image.size())) {
+		std::fprintf(stderr, "verify failed: CRC mismatch in the SRAM\n");
+		return EXIT_FAILURE;
+	}
+	check(client.executeRam(address), "run");
+	std::printf("started %zu bytes at 0x%08x\n", image.size(), unsigned(address));
+	return EXIT_SUCCESS;
+}
+
+int run(const Options &options)
+{
+	const std::string &command = options.arguments[0];
+
+	SerialPort port(options.port, options.baud_rate);
+	BootloaderClient client(port);
+
+	if (options.connect != 0) {
+		if (!options.quiet) {
+			std::fprintf(stderr, "waiting for the bootloader, reset the board\n");
+		}
+		if (!client.connect(std::chrono::milliseconds(options.connect))) {
+			throw std::runtime_error("no sync from the bootloader within " + std::to_string(options.connect) + " ms");
+		}
+	}
+
+	if (options.speed != 0 && options.speed != options.baud_rate) {
+		if (!client.setBaudRate(options.speed)) {
+			std::fprintf(stderr, "no sync at %u baud, staying at %u\n", options.speed, port.baudRate());
+		}
+	}
+
+	if (command == "version") {
+		expectArguments(options, 0);
+		Version version = client.getVersion();
+		std::printf("vendor id: %u\nversion: %u.%u.%u\nwindow size: %u\n", version.vendor_id, version.major,
+		            version.minor, version.patch, version.window_size);
+	} else if (command == "help") {
+		expectArguments(options, 0);
+		for (uint8_t code : client.getHelp()) {
+			std::printf("0x%02x\n", code);
+		}
+	} else if (command == "chip-id") {
+		expectArguments(options, 0);
+		std::printf("0x%03x\n", client.getChipId());
+	} else if (command == "rdp") {
+		expectArguments(options, 0);
+		std::printf("%u\n", client.getRdpLevel());
+	} else if (command == "slots") {
+		expectArguments(options, 0);
+		SlotInfo slots = client.getSlots();
+		for (uint8_t slot = 0; slot < slots.first_pages.size(); slot++) {
+			ImageHeader header = client.getImageHeader(slot);
+			std::printf("slot %c%s: pages %u-%u, ", slotName(slot), slot == slots.active ? " (active)" : "",
+			            slots.first_pages[slot], slots.first_pages[slot] + slots.pages - 1);
+			if (header.magic != kImageMagic) {
+				std::printf("no image\n");
+			} else {
+				std::printf("version %u.%u.%u, %s\n", header.version_major, header.version_minor,
+				            header.version_patch, header.valid ? "valid" : "invalid");
+			}
+		}
+	} else if (command == "set-slot") {
+		expectArguments(options, 1);
+		check(client.setActiveSlot(parseSlot(options.arguments[1])), "set-slot");
+	} else if (command == "swap") {
+		expectArguments(options, 0);
+		uint8_t swapped_pages = 0;
+		check(client.swapImages(swapped_pages), "swap");
+		std::printf("swapped %u pages\n", swapped_pages);
+	} else if (command == "image-info") {
+		if (options.arguments.size() > 2) {
+			expectArguments(options, 1);
+		}
+		uint8_t slot = options.arguments.size() == 2 ? parseSlot(options.arguments[1]) : client.getSlots().active;
+		ImageHeader header = client.getImageHeader(slot);
+		std::printf("slot: %c\n", slotName(slot));
+		if (header.magic != kImageMagic) {
+			std::printf("no image header\n");
+			return EXIT_FAILURE;
+		}
+		std::printf("version: %u.%u.%u\nbuild id: 0x%08x\nload address: 0x%08x\nlength: %u\ncrc: 0x%08x\n",
+		            header.version_major, header.version_minor, header.version_patch, header.build_id,
+		            header.load_address, header.image_length, header.image_crc);
+		std::printf("state: %s%s\n", header.valid ? "valid" : "invalid",
+		            header.valid_marker == kImageValid ? ", cached" : "");
+		if (!header.valid) {
+			return EXIT_FAILURE;
+		}
+	} else if (command == "go") {
+		expectArguments(options, 1);
+		check(client.goToAddress(parseNumber(options.arguments[1])), "go");
+	} else if (command == "erase") {
+		expectArguments(options, 2);
+		uint8_t page = uint8_t(parseNumber(options.arguments[1], kNumberOfPages - 1));
+		uint8_t count = uint8_t(parseNumber(options.arguments[2], kNumberOfPages));
+		check(client.eraseFlash(page, count), "erase");
+	} else if (command == "mass-erase") {
+		expectArguments(options, 0);
+		uint8_t first_free_page = 0;
+		check(client.massErase(first_free_page), "mass erase");
+		std::printf("erased pages %u to %u\n", first_free_page, kNumberOfPages - 1);
+	} else if (command == "write" || command == "read") {
+		if (options.window) {
+			client.setWindowSize(client.getVersion().window_size);
+		}
+		return command == "write" ? commandWrite(client, options) : commandRead(client, options);
+	} else if (command == "crc") {
+		expectArguments(options, 2);
+		std::printf("0x%08x\n", client.getRangeCrc(parseNumber(options.arguments[1]), parseNumber(options.arguments[2])));
+	} else if (command == "crc-pages") {
+		expectArguments(options, 2);
+		uint8_t first = uint8_t(parseNumber(options.arguments[1], kNumberOfPages - 1));
+		uint8_t count = uint8_t(parseNumber(options.arguments[2], kNumberOfPages - first));
+		std::vector<uint32_t> crcs = client.getPageCrcs(first, count);
+		for (size_t i = 0; i < crcs.size(); i++) {
+			std::printf("%3zu 0x%08x\n", first + i, crcs[i]);
+		}
+	} else if (command == "jump") {
+		expectArguments(options, 1);
+		check(client.jumpToApplication(uint8_t(parseNumber(options.arguments[1], kNumberOfPages - 1))), "jump");
+	} else if (command == "run") {
+		return commandRun(client, options);
+	} else if (command == "set-rdp") {
+		expectArguments(options, 1);
+		check(client.setRdpLevel(uint8_t(parseNumber(options.arguments[1], 1))), "set-rdp");
+	} else if (command == "set-baud") {
+		expectArguments(options, 1);
+		uint32_t baud_rate = parseNumber(options.arguments[1]);
+		if (!client.setBaudRate(baud_rate)) {
+			throw std::runtime_error("no sync at " + std::to_string(baud_rate) + " baud");
+		}
+		std::printf("%u\n", baud_rate);
+	} else {
+		throw UsageError("unknown command " + command);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	try {
+		return run(parseArguments(argc, argv));
+	} catch (const UsageError &error) {
+		std::fprintf(stderr, "blflash: %s\n\n%s", error.what(), kUsage);
+		return 2;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "blflash: %s\n", error.what());
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * progress.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "progress.h"
+
+#include <cstdio>
+#include <utility>
+
+#include <unistd.h>
+
+namespace blflash {
+
+Progress::Progress(std::string label, size_t total_bytes, bool quiet)
+	: label_(std::move(label)), total_(total_bytes), quiet_(quiet),
+	  tty_(isatty(STDERR_FILENO) != 0), start_(std::chrono::steady_clock::now()),
+	  last_print_(start_)
+{
+}
+
+void Progress::update(size_t done_bytes)
+{
+	done_ = done_bytes;
+	if (quiet_) {
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	if (tty_) {
+		// redraw at most 10 times per second
+		if (now - last_print_ >= std::chrono::milliseconds(100) || done_bytes == total_) {
+			last_print_ = now;
+			print(done_bytes, false);
+		}
+	} else {
+		int decile = total_ ? int(done_bytes * 10 / total_) : 10;
+		// the 100% line is left to finish()
+		if (decile != last_decile_ && done_bytes < total_) {
+			last_decile_ = decile;
+			print(done_bytes, false);
+		}
+	}
+}
+
+void Progress::finish()
+{
+	if (!quiet_) {
+		print(done_, true);
+	}
+}
+
+void Progress::print(size_t done_bytes, bool final_line)
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+	double rate = seconds > 0 ? done_bytes / seconds / 1024.0 : 0.0;
+	double percent = total_ ? 100.0 * done_bytes / total_ : 100.0;
+
+	std::fprintf(stderr, "%s%s %zu/%zu bytes %5.1f%% %7.2f KiB/s", tty_ ? "\r" : "", label_.c_str(),
+	             done_bytes, total_, percent, rate);
+	if (final_line) {
+		std::fprintf(stderr, " in %.2f s\n", seconds);
+	} else if (!tty_) {
+		std::fprintf(stderr, "\n");
+	}
+	std::fflush(stderr);
+}
+
+} // namespace blflash
@@ -0,0 +1,42 @@
+/*
+ * progress.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_PROGRESS_H_
+#define BLFLASH_PROGRESS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace blflash {
+
+// Progress and throughput of a transfer, printed to stderr. On a terminal
+// the line is redrawn in place, otherwise a line is printed every 10%.
+class Progress {
+public:
+	Progress(std::string label, size_t total_bytes, bool quiet);
+
+	void update(size_t done_bytes);
+	// Prints the final line with the average throughput.
+	void finish();
+
+private:
+	void print(size_t done_bytes, bool final_line);
+
+	std::string label_;
+	size_t total_;
+	bool quiet_;
+	bool tty_;
+	int last_decile_ = -1;
+	std::chrono::steady_clock::time_point start_;
+	std::chrono::steady_clock::time_point last_print_;
+	size_t done_ = 0;
+};
+
+} // namespace blflash
+
+#endif /* BLFLASH_PROGRESS_H_ */
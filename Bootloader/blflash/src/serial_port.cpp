@@ -0,0 +1,211 @@
+/*
+ * serial_port.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "serial_port.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace blflash {
+
+namespace {
+
+[[noreturn]] void throwErrno(const std::string &what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+speed_t toSpeed(uint32_t baud_rate)
+{
+	switch (baud_rate) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+#ifdef B460800
+	case 460800: return B460800;
+#endif
+#ifdef B500000
+	case 500000: return B500000;
+#endif
+#ifdef B576000
+	case 576000: return B576000;
+#endif
+#ifdef B921600
+	case 921600: return B921600;
+#endif
+#ifdef B1000000
+	case 1000000: return B1000000;
+#endif
+#ifdef B1152000
+	case 1152000: return B1152000;
+#endif
+#ifdef B1500000
+	case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+	case 2000000: return B2000000;
+#endif
+	default:
+		throw std::invalid_argument("unsupported baud rate " + std::to_string(baud_rate));
+	}
+}
+
+} // namespace
+
+SerialPort::SerialPort(const std::string &path, uint32_t baud_rate)
+{
+	fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (fd_ < 0) {
+		throwErrno("cannot open " + path);
+	}
+
+	struct termios tty;
+	if (tcgetattr(fd_, &tty) != 0) {
+		int error = errno;
+		::close(fd_);
+		throw std::system_error(error, std::generic_category(), "cannot configure " + path);
+	}
+
+	cfmakeraw(&tty);
+	tty.c_cflag |= CLOCAL | CREAD;
+	tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tty.c_cc[VMIN] = 0;
+	tty.c_cc[VTIME] = 0;
+	if (tcsetattr(fd_, TCSANOW, &tty) != 0) {
+		int error = errno;
+		::close(fd_);
+		throw std::system_error(error, std::generic_category(), "cannot configure " + path);
+	}
+
+	try {
+		setBaudRate(baud_rate);
+	} catch (...) {
+		::close(fd_);
+		throw;
+	}
+	discardInput();
+}
+
+SerialPort::~SerialPort()
+{
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+}
+
+void SerialPort::setBaudRate(uint32_t baud_rate)
+{
+	speed_t speed = toSpeed(baud_rate);
+
+	struct termios tty;
+	if (tcgetattr(fd_, &tty) != 0) {
+		throwErrno("tcgetattr");
+	}
+	cfsetispeed(&tty, speed);
+	cfsetospeed(&tty, speed);
+	// TCSADRAIN lets the bytes already queued go out at the old rate
+	if (tcsetattr(fd_, TCSADRAIN, &tty) != 0) {
+		throwErrno("tcsetattr");
+	}
+	baud_rate_ = baud_rate;
+}
+
+void SerialPort::write(const struct iovec *iov, int count)
+{
+	std::vector<struct iovec> pending(iov, iov + count);
+	size_t first = 0;
+
+	while (first < pending.size()) {
+		ssize_t written = ::writev(fd_, &pending[first], int(pending.size() - first));
+		if (written < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+			throwErrno("serial write");
+		}
+
+		// skip the buffers written completely, trim the one written partially
+		size_t remaining = size_t(written);
+		while (first < pending.size() && remaining >= pending[first].iov_len) {
+			remaining -= pending[first].iov_len;
+			first++;
+		}
+		if (remaining > 0) {
+			pending[first].iov_base = static_cast<uint8_t *>(pending[first].iov_base) + remaining;
+			pending[first].iov_len -= remaining;
+		}
+	}
+}
+
+void SerialPort::write(const uint8_t *data, size_t length)
+{
+	struct iovec iov = {const_cast<uint8_t *>(data), length};
+	write(&iov, 1);
+}
+
+size_t SerialPort::read(uint8_t *data, size_t length, std::chrono::milliseconds timeout)
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point deadline = Clock::now() + timeout;
+	size_t received = 0;
+
+	while (received < length) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+		if (left.count() < 0) {
+			break;
+		}
+
+		struct pollfd pfd = {fd_, POLLIN, 0};
+		int ready = ::poll(&pfd, 1, int(left.count()));
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throwErrno("serial poll");
+		}
+		if (ready == 0) {
+			break;
+		}
+
+		ssize_t count = ::read(fd_, data + received, length - received);
+		if (count < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+			throwErrno("serial read");
+		}
+		received += size_t(count);
+	}
+
+	return received;
+}
+
+void SerialPort::drain()
+{
+	if (tcdrain(fd_) != 0) {
+		throwErrno("tcdrain");
+	}
+}
+
+void SerialPort::discardInput()
+{
+	if (tcflush(fd_, TCIFLUSH) != 0) {
+		throwErrno("tcflush");
+	}
+}
+
+} // namespace blflash
@@ -0,0 +1,52 @@
+/*
+ * serial_port.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#ifndef BLFLASH_SERIAL_PORT_H_
+#define BLFLASH_SERIAL_PORT_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sys/uio.h>
+
+namespace blflash {
+
+// Raw 8N1 serial port on top of termios. Every failure of the underlying
+// system calls is reported as std::system_error.
+class SerialPort {
+public:
+	SerialPort(const std::string &path, uint32_t baud_rate);
+	~SerialPort();
+
+	SerialPort(const SerialPort &) = delete;
+	SerialPort &operator=(const SerialPort &) = delete;
+
+	// Waits for pending output to be sent, then switches the line speed.
+	void setBaudRate(uint32_t baud_rate);
+	uint32_t baudRate() const { return baud_rate_; }
+
+	// Writes all buffers with as few system calls as possible.
+	void write(const struct iovec *iov, int count);
+	void write(const uint8_t *data, size_t length);
+
+	// Reads up to length bytes, returns fewer only if the timeout expires
+	// before they arrive.
+	size_t read(uint8_t *data, size_t length, std::chrono::milliseconds timeout);
+
+	void drain();
+	void discardInput();
+
+private:
+	int fd_ = -1;
+	uint32_t baud_rate_ = 0;
+};
+
+} // namespace blflash
+
+#endif /* BLFLASH_SERIAL_PORT_H_ */
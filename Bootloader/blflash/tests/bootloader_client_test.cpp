@@ -0,0 +1,95 @@
+/*
+ * bootloader_client_test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  Frames BootloaderClient writes and responses it reads, against the
+ *  format Bootloader_Get_Command (bootloader.c) expects.
+ */
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "bootloader_client.h"
+#include "check.h"
+#include "crc32.h"
+#include "fake_serial_port.h"
+
+using namespace blflash;
+using blflash::test::check;
+using blflash::test::parseFrames;
+using blflash::test::queueReply;
+using blflash::test::SentFrame;
+using blflash::test::takeWritten;
+
+int main()
+{
+	SerialPort port("fake", 115200);
+	BootloaderClient client(port);
+
+	// [length][command][CRC], the length counts the command and the CRC
+	queueReply({kAck, 2, 0x10, 0x04});
+	check(client.getChipId() == 0x0410, "chip id is little-endian");
+	Bytes written = takeWritten();
+	const uint8_t covered[3] = {0x05, 0x00, kGetChipId};
+	uint32_t crc = crc32Stm32(covered, sizeof(covered));
+	check(written == Bytes({0x05, 0x00, kGetChipId, uint8_t(crc), uint8_t(crc >> 8), uint8_t(crc >> 16),
+	                        uint8_t(crc >> 24)}),
+	      "stop-and-wait frame layout");
+
+	// bootloaders with windowed frames append their window size to the version
+	queueReply({kAck, 5, 0xAB, 1, 2, 3, 4});
+	Version version = client.getVersion();
+	check(version.major == 1 && version.minor == 2 && version.patch == 3 && version.window_size == 4,
+	      "version with window size");
+	queueReply({kAck, 4, 0xAB, 1, 2, 3});
+	check(client.getVersion().window_size == 0, "version without window size");
+	takeWritten();
+
+	queueReply({0x00});
+	bool nacked = false;
+	try {
+		client.getRdpLevel();
+	} catch (const std::runtime_error &) {
+		nacked = true;
+	}
+	check(nacked, "NACK is reported");
+
+	bool timed_out = false;
+	try {
+		client.getRdpLevel();
+	} catch (const TimeoutError &) {
+		timed_out = true;
+	}
+	check(timed_out, "missing response is a timeout");
+	takeWritten();
+
+	// windowed frames: [length | 0x8000][sequence][command][CRC], answered with
+	// [ACK/NACK][sequence][data length][data]. A NACKed frame is sent again.
+	client.setWindowSize(4);
+	std::vector<Bytes> commands = {{kGetChipId}, {kGetRdpStatus}, {kGetSlot}};
+	queueReply({kAck, 0, 1, 0x10});
+	queueReply({0x00, 1});
+	queueReply({kAck, 2, 1, 0x12});
+	queueReply({kAck, 1, 1, 0x11});
+	std::vector<Response> responses = client.transactAll(commands);
+
+	check(responses.size() == 3, "one response per command");
+	for (size_t i = 0; i < responses.size(); i++) {
+		check(responses[i].ack && responses[i].data == Bytes({uint8_t(0x10 + i)}), "responses in command order");
+	}
+
+	std::vector<SentFrame> frames = parseFrames(takeWritten());
+	std::vector<uint8_t> sequences;
+	bool frames_valid = frames.size() == 4;
+	for (const SentFrame &frame : frames) {
+		frames_valid = frames_valid && frame.valid && frame.windowed && frame.command == commands[frame.sequence];
+		sequences.push_back(frame.sequence);
+	}
+	check(frames_valid, "windowed frames carry their command and a valid CRC");
+	check(sequences == std::vector<uint8_t>({0, 1, 2, 1}), "only the NACKed frame is sent again");
+
+	return test::result();
+}
@@ -0,0 +1,44 @@
+/*
+ * check.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  Minimal assertions for the blflash tests, run by CTest.
+ */
+
+#ifndef BLFLASH_TESTS_CHECK_H_
+#define BLFLASH_TESTS_CHECK_H_
+
+#include <cstdio>
+
+namespace blflash {
+namespace test {
+
+inline int &failures()
+{
+	static int count = 0;
+	return count;
+}
+
+inline void check(bool condition, const char *what)
+{
+	if (!condition) {
+		std::fprintf(stderr, "FAIL: %s\n", what);
+		failures()++;
+	}
+}
+
+// Exit status of a test program: 0 when every check passed.
+inline int result()
+{
+	if (failures()) {
+		std::fprintf(stderr, "%d check(s) failed\n", failures());
+	}
+	return failures() ? 1 : 0;
+}
+
+} // namespace test
+} // namespace blflash
+
+#endif /* BLFLASH_TESTS_CHECK_H_ */
@@ -0,0 +1,67 @@
+/*
+ * crc32_test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  crc32Stm32 against the values of the STM32 CRC unit and a bit by bit
+ *  implementation of it.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "crc32.h"
+
+using namespace blflash;
+using blflash::test::check;
+
+namespace {
+
+// One bit at a time, as the CRC unit shifts each 32-bit word in.
+uint32_t crc32Bitwise(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < length; i += 4) {
+		uint32_t word = 0;
+		for (size_t byte = 0; byte < 4 && i + byte < length; byte++) {
+			word |= uint32_t(data[i + byte]) << (8 * byte);
+		}
+		crc ^= word;
+		for (int bit = 0; bit < 32; bit++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+} // namespace
+
+int main()
+{
+	// CRC->DR after a reset and one write of 0x00000000, then of 0x12345678
+	const uint8_t zero[4] = {0x00, 0x00, 0x00, 0x00};
+	const uint8_t word[4] = {0x78, 0x56, 0x34, 0x12};
+	check(crc32Stm32(zero, sizeof(zero)) == 0xC704DD7B, "CRC of a zero word");
+	check(crc32Stm32(word, sizeof(word)) == 0xDF8A8A2B, "CRC of 0x12345678");
+	check(crc32Stm32(nullptr, 0) == 0xFFFFFFFF, "CRC of nothing is the reset value");
+
+	// a last partial word is zero-padded, as the bootloader pads it
+	const uint8_t partial[6] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	const uint8_t padded[8] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x00, 0x00};
+	check(crc32Stm32(partial, sizeof(partial)) == crc32Stm32(padded, sizeof(padded)), "partial word is zero-padded");
+
+	std::mt19937 random(1);
+	std::vector<uint8_t> data(4099);
+	for (auto &byte : data) {
+		byte = uint8_t(random());
+	}
+	for (size_t length = 0; length <= data.size(); length += (length < 64) ? 1 : 509) {
+		check(crc32Stm32(data.data(), length) == crc32Bitwise(data.data(), length), "table CRC matches the bitwise CRC");
+	}
+
+	return test::result();
+}
@@ -0,0 +1,126 @@
+/*
+ * fake_serial_port.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ */
+
+#include "fake_serial_port.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "crc32.h"
+#include "serial_port.h"
+
+namespace blflash {
+
+namespace {
+
+constexpr uint16_t kWindowFrameFlag = 0x8000;
+
+std::deque<uint8_t> &replies()
+{
+	static std::deque<uint8_t> bytes;
+	return bytes;
+}
+
+Bytes &written()
+{
+	static Bytes bytes;
+	return bytes;
+}
+
+} // namespace
+
+SerialPort::SerialPort(const std::string &, uint32_t baud_rate) : baud_rate_(baud_rate)
+{
+}
+
+SerialPort::~SerialPort()
+{
+}
+
+void SerialPort::setBaudRate(uint32_t baud_rate)
+{
+	baud_rate_ = baud_rate;
+}
+
+void SerialPort::write(const struct iovec *iov, int count)
+{
+	for (int i = 0; i < count; i++) {
+		write(static_cast<const uint8_t *>(iov[i].iov_base), iov[i].iov_len);
+	}
+}
+
+void SerialPort::write(const uint8_t *data, size_t length)
+{
+	written().insert(written().end(), data, data + length);
+}
+
+size_t SerialPort::read(uint8_t *data, size_t length, std::chrono::milliseconds)
+{
+	size_t count = std::min(length, replies().size());
+	std::copy_n(replies().begin(), count, data);
+	replies().erase(replies().begin(), replies().begin() + long(count));
+	return count;
+}
+
+void SerialPort::drain()
+{
+}
+
+// the queued replies are the answers still to come, not stale input
+void SerialPort::discardInput()
+{
+}
+
+namespace test {
+
+void queueReply(const Bytes &bytes)
+{
+	replies().insert(replies().end(), bytes.begin(), bytes.end());
+}
+
+Bytes takeWritten()
+{
+	Bytes bytes;
+	bytes.swap(written());
+	return bytes;
+}
+
+std::vector<SentFrame> parseFrames(const Bytes &written)
+{
+	std::vector<SentFrame> frames;
+
+	for (size_t index = 0; index + 2 <= written.size();) {
+		SentFrame frame;
+		uint16_t length_field = uint16_t(written[index] | written[index + 1] << 8);
+		size_t length = length_field & ~kWindowFrameFlag;
+		size_t header_length = 2;
+		frame.windowed = (length_field & kWindowFrameFlag) != 0;
+		if (frame.windowed) {
+			frame.sequence = written[index + 2];
+			header_length = 3;
+		}
+
+		// length counts everything after the length field, CRC included
+		size_t end = index + 2 + length;
+		if (length < header_length - 2 + 4 || end > written.size()) {
+			frames.push_back(frame);
+			break;
+		}
+		size_t crc_offset = end - 4;
+		uint32_t crc = uint32_t(written[crc_offset]) | uint32_t(written[crc_offset + 1]) << 8 |
+		               uint32_t(written[crc_offset + 2]) << 16 | uint32_t(written[crc_offset + 3]) << 24;
+		frame.command.assign(written.begin() + long(index + header_length), written.begin() + long(crc_offset));
+		frame.valid = crc == crc32Stm32(written.data() + index, crc_offset - index);
+		frames.push_back(frame);
+		index = end;
+	}
+	return frames;
+}
+
+} // namespace test
+
+} // namespace blflash
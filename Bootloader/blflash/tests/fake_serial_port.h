@@ -0,0 +1,42 @@
+/*
+ * fake_serial_port.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  SerialPort replaced by two buffers, so the client tests run without a
+ *  board: what the client writes is kept, what it reads is queued up front.
+ */
+
+#ifndef BLFLASH_TESTS_FAKE_SERIAL_PORT_H_
+#define BLFLASH_TESTS_FAKE_SERIAL_PORT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "bootloader_client.h"
+
+namespace blflash {
+namespace test {
+
+// A frame as the bootloader sees it after checking its length and CRC.
+struct SentFrame {
+	bool windowed = false;
+	uint8_t sequence = 0;
+	Bytes command;
+	bool valid = false;
+};
+
+// Queues bytes for the client to read, a read past them times out.
+void queueReply(const Bytes &bytes);
+
+// Bytes written by the client since the last call.
+Bytes takeWritten();
+
+// Splits written bytes into frames.
+std::vector<SentFrame> parseFrames(const Bytes &written);
+
+} // namespace test
+} // namespace blflash
+
+#endif /* BLFLASH_TESTS_FAKE_SERIAL_PORT_H_ */
@@ -0,0 +1,83 @@
+/*
+ * image_header_test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  makeImageHeader and parseImageHeader, checked the way
+ *  BL_Image_Check_Header (bl_image.c) checks a header in a slot.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bootloader_client.h"
+#include "check.h"
+#include "crc32.h"
+#include "image_header.h"
+
+using namespace blflash;
+using blflash::test::check;
+
+namespace {
+
+constexpr uint32_t kFlashBase = 0x08000000;
+// the header CRC covers the fields in front of it
+constexpr size_t kHeaderCrcOffset = 24;
+
+// What the bootloader accepts for a header found at header_address.
+bool bootloaderAccepts(const Bytes &header, uint32_t header_address)
+{
+	ImageHeader fields = parseImageHeader(header.data());
+	uint32_t image_address = header_address + uint32_t(kImageHeaderSize);
+	uint32_t flash_end = kFlashBase + uint32_t(kNumberOfPages) * kPageSize;
+
+	return fields.magic == kImageMagic && fields.header_crc == crc32Stm32(header.data(), kHeaderCrcOffset) &&
+	       fields.load_address == image_address && fields.image_length > 0 &&
+	       fields.image_length <= flash_end - image_address;
+}
+
+} // namespace
+
+int main()
+{
+	std::mt19937 random(1);
+	Bytes image(3001);
+	for (auto &byte : image) {
+		byte = uint8_t(random());
+	}
+
+	const uint32_t header_address = kFlashBase + 24 * kPageSize;
+	Bytes header = makeImageHeader(header_address, image, 1, 2, 0x0304, 0xDEADBEEF);
+	ImageHeader fields = parseImageHeader(header.data());
+
+	check(header.size() == kImageHeaderSize, "header fills the header region");
+	check(fields.magic == kImageMagic, "magic");
+	check(fields.load_address == header_address + kImageHeaderSize, "image runs right after the header");
+	check(fields.image_length == image.size(), "image length");
+	check(fields.image_crc == crc32Stm32(image.data(), image.size()), "image CRC");
+	check(fields.version_major == 1 && fields.version_minor == 2 && fields.version_patch == 0x0304, "version");
+	check(fields.build_id == 0xDEADBEEF, "build id");
+	check(fields.header_crc == crc32Stm32(header.data(), kHeaderCrcOffset), "header CRC");
+	check(fields.valid_marker == 0xFFFFFFFF, "validity marker left erased");
+
+	bool padded = true;
+	for (size_t i = kImageHeaderLength; i < header.size(); i++) {
+		padded = padded && header[i] == 0xFF;
+	}
+	check(padded, "padding is erased flash");
+
+	// fields are little-endian, as the Cortex-M3 reads them
+	check(header[0] == 0x42 && header[1] == 0x49 && header[2] == 0x4D && header[3] == 0x47, "magic byte order");
+	check(header[18] == 0x04 && header[19] == 0x03, "patch byte order");
+
+	check(bootloaderAccepts(header, header_address), "bootloader accepts the header");
+	check(!bootloaderAccepts(header, header_address + kPageSize), "header linked for another slot is refused");
+
+	Bytes changed = header;
+	changed[20] ^= 0x01;
+	check(!bootloaderAccepts(changed, header_address), "changed field fails the header CRC");
+
+	return test::result();
+}
@@ -0,0 +1,172 @@
+/*
+ * lz4_test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  Round trip of lz4Compress through a decoder that mirrors
+ *  Bootloader_LZ_Decompress (bootloader.c), including its limits: no match
+ *  reaches back more than the window, and the stream ends with the literals
+ *  that complete the image.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bootloader_client.h"
+#include "check.h"
+#include "lz4.h"
+
+using namespace blflash;
+using blflash::test::check;
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr uint8_t kLengthExtended = 15;
+
+// Decodes like the bootloader: through a kLzWindowSize byte ring, refusing
+// an offset of zero, beyond the window or before the image start, and any
+// length past image_length. The whole stream has to be used by the image.
+bool decompress(const Bytes &input, size_t image_length, Bytes &output)
+{
+	Bytes window(kLzWindowSize);
+	size_t input_index = 0;
+	bool corrupted = false;
+
+	auto readByte = [&]() -> uint8_t {
+		if (input_index == input.size()) {
+			corrupted = true;
+			return 0;
+		}
+		return input[input_index++];
+	};
+	auto readLength = [&](uint8_t nibble) -> size_t {
+		size_t length = nibble;
+		if (nibble == kLengthExtended) {
+			uint8_t extra = 0;
+			do {
+				extra = readByte();
+				length += extra;
+			} while (extra == 255 && length <= image_length);
+		}
+		return length;
+	};
+	auto writeByte = [&](uint8_t byte) {
+		window[output.size() & (kLzWindowSize - 1)] = byte;
+		output.push_back(byte);
+	};
+
+	output.clear();
+	while (output.size() < image_length && !corrupted) {
+		uint8_t token = readByte();
+		size_t literal_length = readLength(token >> 4);
+		if (literal_length > image_length - output.size()) {
+			corrupted = true;
+			break;
+		}
+
+		for (size_t i = 0; i < literal_length; i++) {
+			uint8_t literal = readByte();
+			if (corrupted) {
+				break;
+			}
+			writeByte(literal);
+		}
+		if (output.size() == image_length || corrupted) {
+			break;
+		}
+
+		size_t offset = readByte();
+		offset |= size_t(readByte()) << 8;
+		size_t match_length = readLength(token & 0x0F) + kMinMatch;
+		if (offset == 0 || offset > kLzWindowSize || offset > output.size() ||
+		    match_length > image_length - output.size()) {
+			corrupted = true;
+			break;
+		}
+
+		for (size_t i = 0; i < match_length; i++) {
+			writeByte(window[(output.size() - offset) & (kLzWindowSize - 1)]);
+		}
+	}
+
+	return !corrupted && input_index == input.size();
+}
+
+bool roundTrip(const Bytes &data)
+{
+	Bytes output;
+	return decompress(lz4Compress(data, kLzWindowSize), data.size(), output) && output == data;
+}
+
+Bytes randomBytes(std::mt19937 &random, size_t length)
+{
+	Bytes data(length);
+	for (auto &byte : data) {
+		byte = uint8_t(random());
+	}
+	return data;
+}
+
+// length bytes repeating a random block of period bytes
+Bytes repeated(std::mt19937 &random, size_t period, size_t length)
+{
+	Bytes block = randomBytes(random, period);
+	Bytes data;
+	while (data.size() < length) {
+		data.insert(data.end(), block.begin(), block.end());
+	}
+	data.resize(length);
+	return data;
+}
+
+} // namespace
+
+int main()
+{
+	std::mt19937 random(1);
+
+	// images shorter than a match plus the literal tail are all literals
+	for (size_t length = 1; length <= 16; length++) {
+		check(roundTrip(Bytes(length, 0xA5)), "short image");
+	}
+
+	// long matches and long literal runs need the extended length bytes
+	check(roundTrip(Bytes(20000, 0x00)), "erased-flash-like image");
+	check(lz4Compress(Bytes(20000, 0x00), kLzWindowSize).size() < 200, "a constant image compresses");
+	check(roundTrip(randomBytes(random, 5000)), "incompressible image");
+
+	Bytes mixed;
+	for (int part = 0; part < 40; part++) {
+		Bytes chunk = (part % 3) ? randomBytes(random, 1 + random() % 300) : Bytes(1 + random() % 700, 0xFF);
+		mixed.insert(mixed.end(), chunk.begin(), chunk.end());
+	}
+	check(roundTrip(mixed), "mixed literals and matches");
+
+	// a repeat exactly one window back is used, one past it can not be
+	Bytes in_window = repeated(random, kLzWindowSize, 4 * kLzWindowSize);
+	Bytes past_window = repeated(random, kLzWindowSize + 1, 4 * kLzWindowSize);
+	check(roundTrip(in_window), "repeat at the window size");
+	check(roundTrip(past_window), "repeat past the window size");
+	check(lz4Compress(in_window, kLzWindowSize).size() < in_window.size() / 2, "repeat at the window size is matched");
+	check(lz4Compress(past_window, kLzWindowSize).size() > past_window.size(), "repeat past the window size is not matched");
+
+	// the mirror refuses what the bootloader refuses
+	Bytes output;
+	Bytes literals(kLzWindowSize + 1, 0x11);
+	Bytes stream = {0xF0, uint8_t(kLzWindowSize + 1 - 15 - 255 * 7)};
+	stream.insert(stream.begin() + 1, 7, 255);
+	stream.insert(stream.end(), literals.begin(), literals.end());
+	Bytes too_far = stream;
+	too_far.push_back(uint8_t(kLzWindowSize + 1));
+	too_far.push_back(uint8_t((kLzWindowSize + 1) >> 8));
+	check(decompress(stream, literals.size(), output) && output == literals, "hand-made literal stream");
+	check(!decompress(too_far, literals.size() + kMinMatch, output), "offset past the window is refused");
+	check(!decompress({0x00, 0x01, 0x00}, kMinMatch, output), "match before the image start is refused");
+	check(!decompress({0x10, 0x42, 0x00}, 1, output), "bytes after the image are refused");
+	check(!decompress({0x20, 0x42}, 2, output), "truncated stream is refused");
+
+	return test::result();
+}
@@ -0,0 +1,143 @@
+/*
+ * page_crc_test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: abdelrahman
+ *
+ *  BL_GET_CRC_CMD as sent by getRangeCrc and getPageCrcs, answered with the
+ *  CRCs Bootloader_Get_CRC (bootloader.c) computes over a simulated flash.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "bootloader_client.h"
+#include "check.h"
+#include "crc32.h"
+#include "fake_serial_port.h"
+
+using namespace blflash;
+using blflash::test::check;
+using blflash::test::parseFrames;
+using blflash::test::queueReply;
+using blflash::test::SentFrame;
+using blflash::test::takeWritten;
+
+namespace {
+
+constexpr uint8_t kCrcModeRange = 0;
+constexpr uint8_t kCrcModePages = 1;
+// page CRCs in one response of at most kMaxResponseLength bytes
+constexpr uint8_t kCrcMaxPages = kMaxResponseLength / 4;
+
+void putLe32(Bytes &out, uint32_t value)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		out.push_back(uint8_t(value >> shift));
+	}
+}
+
+uint32_t pageCrc(const Bytes &flash, size_t page)
+{
+	return crc32Stm32(flash.data() + page * kPageSize, kPageSize);
+}
+
+// Answers a page manifest request the way the bootloader does.
+void queuePageCrcs(const Bytes &flash, uint8_t start_page, uint8_t number_of_pages)
+{
+	Bytes reply = {kAck, uint8_t(4 * number_of_pages)};
+	for (uint8_t page = start_page; page < start_page + number_of_pages; page++) {
+		putLe32(reply, pageCrc(flash, page));
+	}
+	queueReply(reply);
+}
+
+} // namespace
+
+int main()
+{
+	SerialPort port("fake", 115200);
+	BootloaderClient client(port);
+
+	// more pages than one response holds
+	const uint8_t number_of_pages = 64;
+	std::mt19937 random(1);
+	Bytes flash(number_of_pages * kPageSize, 0xFF);
+	for (size_t i = 0; i < 40 * kPageSize; i++) {
+		flash[i] = uint8_t(random());
+	}
+
+	// range CRC: [mode][address][length], answered with the CRC
+	Bytes reply = {kAck, 4};
+	putLe32(reply, 0x12345678);
+	queueReply(reply);
+	check(client.getRangeCrc(0x08006000, 0x1234) == 0x12345678, "range CRC is little-endian");
+	std::vector<SentFrame> frames = parseFrames(takeWritten());
+	Bytes range_command = {kGetCrc, kCrcModeRange};
+	putLe32(range_command, 0x08006000);
+	putLe32(range_command, 0x1234);
+	check(frames.size() == 1 && frames[0].valid && frames[0].command == range_command, "range CRC command");
+
+	// page manifest: [mode][first page][number of pages], split by response size
+	queuePageCrcs(flash, 0, kCrcMaxPages);
+	queuePageCrcs(flash, kCrcMaxPages, number_of_pages - kCrcMaxPages);
+	std::vector<uint32_t> crcs = client.getPageCrcs(0, number_of_pages);
+	frames = parseFrames(takeWritten());
+	check(frames.size() == 2 && frames[0].command == Bytes({kGetCrc, kCrcModePages, 0, kCrcMaxPages}) &&
+	          frames[1].command == Bytes({kGetCrc, kCrcModePages, kCrcMaxPages, uint8_t(number_of_pages - kCrcMaxPages)}),
+	      "manifest split into full responses");
+
+	bool manifest = crcs.size() == number_of_pages;
+	for (size_t page = 0; manifest && page < number_of_pages; page++) {
+		manifest = crcs[page] == pageCrc(flash, page);
+	}
+	check(manifest, "one CRC per page, in page order");
+
+	// an image differing from the flash in one page, its tail padded with
+	// erased flash, shows up as that page only
+	Bytes image(flash.begin(), flash.begin() + long(40 * kPageSize - 100));
+	image[17 * kPageSize + 5] ^= 0x01;
+	std::vector<size_t> changed;
+	for (size_t page = 0; page < 40; page++) {
+		Bytes padded(kPageSize, 0xFF);
+		size_t length = std::min<size_t>(kPageSize, image.size() - page * kPageSize);
+		std::copy_n(image.begin() + long(page * kPageSize), length, padded.begin());
+		if (crc32Stm32(padded.data(), padded.size()) != crcs[page]) {
+			changed.push_back(page);
+		}
+	}
+	check(changed == std::vector<size_t>({17, 39}), "only changed pages differ from the manifest");
+
+	// windowed frames deliver the same manifest
+	client.setWindowSize(4);
+	queueReply({kAck, 0, uint8_t(4 * kCrcMaxPages)});
+	for (uint8_t page = 0; page < kCrcMaxPages; page++) {
+		Bytes crc;
+		putLe32(crc, pageCrc(flash, page));
+		queueReply(crc);
+	}
+	queueReply({kAck, 1, 4});
+	Bytes last;
+	putLe32(last, pageCrc(flash, kCrcMaxPages));
+	queueReply(last);
+	check(client.getPageCrcs(0, kCrcMaxPages + 1) ==
+	          std::vector<uint32_t>(crcs.begin(), crcs.begin() + kCrcMaxPages + 1),
+	      "windowed manifest");
+	takeWritten();
+	client.setWindowSize(0);
+
+	// a manifest missing a page is refused
+	queuePageCrcs(flash, 0, 2);
+	bool refused = false;
+	try {
+		client.getPageCrcs(0, 3);
+	} catch (const std::runtime_error &) {
+		refused = true;
+	}
+	check(refused, "short manifest is refused");
+
+	return test::result();
+}